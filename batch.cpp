@@ -0,0 +1,193 @@
+#include "batch.hpp"
+
+#include <stdexcept>
+
+// The lanes where a cell is black, for each cell of the board
+using Slices = std::vector<uint64_t>;
+
+// The cells of region connected to seeds through region, lane by lane
+static Slices flood(const YGame& game, const Slices& seeds, const Slices& region) {
+
+    const auto& graph = game.graph();
+    const auto cells = graph.size();
+
+    auto reach = seeds;
+
+    // Sweep back and forth until nothing changes, which takes about as many
+    // passes as the longest path doubles back on the cell order
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (size_t i = 0; i < 2 * cells; ++i) {
+            const auto cell = (i < cells) ? i : 2 * cells - 1 - i;
+
+            uint64_t next = reach.at(cell);
+            for (const auto nhbr : graph.at(cell)) {
+                next |= reach.at(nhbr);
+            }
+            next &= region.at(cell);
+
+            if (next != reach.at(cell)) {
+                reach.at(cell) = next;
+                changed = true;
+            }
+        }
+    }
+
+    return reach;
+}
+
+// The lanes where some group of black cells touches all three edges
+static uint64_t connects(const YGame& game, const Slices& black) {
+
+    const auto cells = game.graph().size();
+
+    const auto on_edge = [&](const Cell cell, const Edge edge) {
+        return (static_cast<uint8_t>(game.cell_edge(cell)) & static_cast<uint8_t>(edge)) != 0;
+    };
+
+    // The groups touching the right edge, then those of them also touching the left edge
+    Slices seeds(cells, 0);
+    for (Cell cell = 0; cell < cells; ++cell) {
+        seeds.at(cell) = on_edge(cell, Edge::Right) ? black.at(cell) : 0;
+    }
+    const auto right_groups = flood(game, seeds, black);
+
+    for (Cell cell = 0; cell < cells; ++cell) {
+        seeds.at(cell) = on_edge(cell, Edge::Left) ? right_groups.at(cell) : 0;
+    }
+    const auto both_groups = flood(game, seeds, right_groups);
+
+    uint64_t lanes = 0;
+    for (Cell cell = 0; cell < cells; ++cell) {
+        if (on_edge(cell, Edge::Bottom)) {
+            lanes |= both_groups.at(cell);
+        }
+    }
+
+    return lanes;
+}
+
+std::vector<Outcome> solve_lanes(const YGame& game, const std::vector<const BatchPosition*>& lanes) {
+
+    if (lanes.empty() || (lanes.size() > batch_lanes)) {
+        throw std::runtime_error("solve_lanes: invalid number of positions");
+    }
+
+    const auto cells = game.graph().size();
+
+    // Every lane fills its own empty cells in the same order: the first player
+    // to move in each lane gets some of them, and the other player the rest
+    std::vector<std::vector<Cell>> empties{};
+    Slices fixed(cells, 0);
+    uint64_t first_black = 0;
+
+    for (size_t lane = 0; lane < lanes.size(); ++lane) {
+        const auto& pos = *lanes.at(lane);
+        const auto bit = uint64_t{1} << lane;
+
+        std::vector<Cell> empty{};
+        for (Cell cell = 0; cell < cells; ++cell) {
+            const auto owner = pos.state.board.at(cell).player;
+            if (owner == Player::None) {
+                empty.push_back(cell);
+            } else if (owner == Player::Black) {
+                fixed.at(cell) |= bit;
+            }
+        }
+
+        if ((lane > 0) && (empty.size() != empties.front().size())) {
+            throw std::runtime_error("solve_lanes: positions have different numbers of empty cells");
+        }
+        empties.push_back(empty);
+
+        if (pos.player == Player::Black) {
+            first_black |= bit;
+        }
+    }
+
+    const auto size = empties.front().size();
+    if (size > batch_max_moves) {
+        throw std::runtime_error("solve_lanes: too many empty cells");
+    }
+
+    // The lanes where the first player wins, for each set of empty cells they fill
+    std::vector<uint64_t> first_wins(size_t{1} << size);
+    for (uint32_t mask = 0; mask < first_wins.size(); ++mask) {
+
+        auto black = fixed;
+        for (size_t lane = 0; lane < lanes.size(); ++lane) {
+            const auto bit = uint64_t{1} << lane;
+            const auto first = (first_black & bit) != 0;
+
+            for (size_t i = 0; i < size; ++i) {
+                const auto mine = ((mask >> i) & 1) != 0;
+                if (mine == first) {
+                    black.at(empties.at(lane).at(i)) |= bit;
+                }
+            }
+        }
+
+        const auto black_wins = connects(game, black);
+        first_wins.at(mask) = (black_wins & first_black) | (~black_wins & ~first_black);
+    }
+
+    // The partial fillings by base 3 digits, 0 empty, 1 the first player's and
+    // 2 the second player's. Filling a cell only ever increases the index, so
+    // going down from the top sees every child before its parent.
+    uint32_t states = 1;
+    std::vector<uint32_t> powers(size);
+    for (size_t i = 0; i < size; ++i) {
+        powers.at(i) = states;
+        states *= 3;
+    }
+
+    // The lanes where the player to move wins
+    std::vector<uint64_t> wins(states);
+
+    for (uint32_t s = states; s-- > 0;) {
+
+        uint32_t filled = 0;
+        uint32_t first = 0;
+        uint32_t empty = 0;
+
+        auto rest = s;
+        for (size_t i = 0; i < size; ++i) {
+            const auto digit = rest % 3;
+            rest /= 3;
+
+            if (digit == 0) {
+                empty |= 1u << i;
+            } else {
+                ++filled;
+                if (digit == 1) {
+                    first |= 1u << i;
+                }
+            }
+        }
+
+        if (empty == 0) {
+            // With no moves left the first player is to move when there were an even number
+            wins.at(s) = (size % 2 == 0) ? first_wins.at(first) : ~first_wins.at(first);
+            continue;
+        }
+
+        const auto digit = (filled % 2 == 0) ? 1 : 2;
+
+        uint64_t win = 0;
+        for (auto left = empty; left != 0; left &= left - 1) {
+            const auto i = __builtin_ctz(left);
+            win |= ~wins.at(s + digit * powers.at(i));
+        }
+        wins.at(s) = win;
+    }
+
+    std::vector<Outcome> outcomes{};
+    for (size_t lane = 0; lane < lanes.size(); ++lane) {
+        const auto won = ((wins.at(0) >> lane) & 1) != 0;
+        outcomes.push_back(won ? Outcome::Win : Outcome::Lose);
+    }
+
+    return outcomes;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+struct BatchPosition {
+    State state;
+    Player player;
+
+    explicit BatchPosition(const State& state_, const Player player_) : state{state_}, player{player_} {}
+};
+
+// The most empty cells a position can have to be solved in lanes, which keeps
+// the table of partial fillings to a few megabytes per batch
+constexpr uint32_t batch_max_moves = 13;
+
+// The number of positions solved at once, one per bit of a word
+constexpr uint32_t batch_lanes = 64;
+
+// Decide up to batch_lanes positions with the same number of empty cells in
+// lockstep. Each position is a bit lane: a board is one word per cell, with
+// the lanes where that cell is black set, so a flood fill over the graph finds
+// every lane's groups together. As in the endgame solver, the filled boards
+// decide the game, so every filling of the i-th empty cells of all the lanes
+// is checked for a win at once, and the players' choices are then solved over
+// the partial fillings with one word of outcomes per filling.
+std::vector<Outcome> solve_lanes(const YGame& game, const std::vector<const BatchPosition*>& lanes);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// A set of cells as a 256 bit mask, enough for any board since cells fit in a uint8_t
+struct Bits {
+    std::array<uint64_t, 4> words;
+
+    explicit Bits() : words{} {}
+
+    bool test(const uint32_t cell) const {
+        return (words[cell / 64] >> (cell % 64)) & 1;
+    }
+
+    void set(const uint32_t cell) {
+        words[cell / 64] |= uint64_t{1} << (cell % 64);
+    }
+
+    void reset(const uint32_t cell) {
+        words[cell / 64] &= ~(uint64_t{1} << (cell % 64));
+    }
+
+    bool any() const {
+        return (words[0] | words[1] | words[2] | words[3]) != 0;
+    }
+
+    uint32_t count() const {
+        uint32_t n = 0;
+        for (const auto word : words) {
+            n += static_cast<uint32_t>(__builtin_popcountll(word));
+        }
+        return n;
+    }
+
+    Bits operator&(const Bits& other) const {
+        Bits bits{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            bits.words[i] = words[i] & other.words[i];
+        }
+        return bits;
+    }
+
+    Bits operator|(const Bits& other) const {
+        Bits bits{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            bits.words[i] = words[i] | other.words[i];
+        }
+        return bits;
+    }
+
+    Bits operator~() const {
+        Bits bits{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            bits.words[i] = ~words[i];
+        }
+        return bits;
+    }
+
+    Bits& operator&=(const Bits& other) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            words[i] &= other.words[i];
+        }
+        return *this;
+    }
+
+    Bits& operator|=(const Bits& other) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            words[i] |= other.words[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const Bits& other) const {
+        return words == other.words;
+    }
+};
@@ -0,0 +1,313 @@
+#include "book.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "negamax.hpp"
+#include "trace.hpp"
+#include "util.hpp"
+
+// The book file is a header followed by fixed size records, each a packed
+// canonical position and its outcome for the player to move. The header names
+// the board, and the canonical root position and depth the book was built
+// below, so a build is only resumed into the book it started. Records are
+// appended as positions are solved, so an interrupted build can be resumed,
+// and sorted once the build completes so they can be binary searched.
+static const std::string book_magic = "YBOOK002";
+
+// The magic, fingerprint and number of cells, which any book for the board starts with
+static std::string board_header(const YGame& game) {
+    std::ostringstream header{};
+    header << book_magic;
+    write_uint(header, fingerprint(game), 8);
+    write_uint(header, game.graph().size(), 4);
+    return header.str();
+}
+
+static std::string book_header(const YGame& game, const Key& root, const Cell depth) {
+    const auto cells = game.graph().size();
+
+    std::ostringstream header{};
+    header << board_header(game);
+
+    std::vector<uint8_t> bytes(key_bytes(cells));
+    write_key(root, cells, bytes.data());
+    header.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    write_uint(header, depth, 1);
+    return header.str();
+}
+
+static size_t header_size(const YGame& game) {
+    return board_header(game).size() + key_bytes(game.graph().size()) + 1;
+}
+
+static void write_record(std::ostream& os, const size_t cells, const Key& key, const Outcome outcome) {
+    std::vector<uint8_t> bytes(key_bytes(cells));
+    write_key(key, cells, bytes.data());
+    os.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    write_uint(os, static_cast<uint64_t>(outcome), 1);
+}
+
+static std::vector<std::pair<Key, Outcome>> load_entries(const YGame& game, const std::string& path) {
+
+    const auto data = read_file(path);
+
+    if (data.compare(0, book_magic.size(), book_magic) != 0) {
+        throw std::runtime_error("error: " + path + " is not a book file");
+    }
+
+    const auto header = board_header(game);
+    if (data.compare(0, header.size(), header) != 0) {
+        throw std::runtime_error("error: book " + path + " was built for a different board");
+    }
+
+    if (data.size() < header_size(game)) {
+        throw std::runtime_error("error: book " + path + " is shorter than its header");
+    }
+
+    const auto cells = game.graph().size();
+    const auto record = key_bytes(cells) + 1;
+
+    std::vector<std::pair<Key, Outcome>> entries{};
+
+    // A partially written record at the end is left over from an interrupted build, so ignore it
+    for (size_t pos = header_size(game); pos + record <= data.size(); pos += record) {
+        const auto bytes = reinterpret_cast<const uint8_t*>(data.data() + pos);
+        if (bytes[record - 1] > 1) {
+            throw std::runtime_error("error: book " + path + " has an invalid outcome at byte " + std::to_string(pos + record - 1));
+        }
+
+        const auto outcome = static_cast<Outcome>(bytes[record - 1]);
+        entries.emplace_back(read_key(bytes, cells), outcome);
+    }
+
+    std::sort(std::begin(entries), std::end(entries));
+
+    const auto same = [](const std::pair<Key, Outcome>& a, const std::pair<Key, Outcome>& b) {
+        return a.first == b.first;
+    };
+    entries.erase(std::unique(std::begin(entries), std::end(entries), same), std::end(entries));
+
+    return entries;
+}
+
+// Cut off a partially written record left at the end by an interrupted build,
+// so that the records appended on resuming stay aligned
+static void drop_partial_record(const YGame& game, const std::string& path) {
+
+    struct stat info {};
+    if (stat(path.c_str(), &info) != 0) {
+        throw std::runtime_error("error: unable to read " + path);
+    }
+
+    const auto size = static_cast<size_t>(info.st_size);
+    const auto header = header_size(game);
+    if (size < header) {
+        throw std::runtime_error("error: book " + path + " is shorter than its header");
+    }
+
+    const auto record = key_bytes(game.graph().size()) + 1;
+    const auto whole = header + (size - header) / record * record;
+
+    if ((whole != size) && (truncate(path.c_str(), static_cast<off_t>(whole)) != 0)) {
+        throw std::runtime_error("error: unable to truncate " + path);
+    }
+}
+
+Book::Book(const YGame& game, const std::string& path) {
+    entries_ = load_entries(game, path);
+}
+
+bool Book::lookup(const Key& key, Outcome& outcome) const {
+
+    const auto less = [](const std::pair<Key, Outcome>& entry, const Key& k) {
+        return entry.first < k;
+    };
+
+    const auto it = std::lower_bound(std::begin(entries_), std::end(entries_), key, less);
+    if ((it == std::end(entries_)) || (it->first != key)) {
+        return false;
+    }
+
+    outcome = it->second;
+    return true;
+}
+
+struct BookPosition {
+    State state;
+    Player player;
+    Key key;
+
+    explicit BookPosition(const State& state_, const Player player_, const Key& key_)
+        : state{state_}, player{player_}, key{key_} {}
+};
+
+// Enumerate the symmetry-distinct positions at each depth below the root.
+// Positions that are already won are left out, since they need no solving.
+static std::vector<std::vector<BookPosition>> enumerate(const State& state, const YGame& game, const Player player, const Cell depth) {
+
+    std::vector<std::vector<BookPosition>> levels{};
+    levels.push_back({BookPosition{state, player, canonical_key(state, game, player)}});
+
+    for (Cell d = 1; d <= depth; ++d) {
+
+        std::map<Key, BookPosition> next{};
+
+        for (const auto& pos : levels.back()) {
+            for (const auto cell : unique_moves(pos.state, game, pos.player)) {
+
+                State child = pos.state;
+                child.move(game, pos.player, cell);
+
+                if (child.won(cell)) {
+                    continue;
+                }
+
+                const auto key = canonical_key(child, game, !pos.player);
+                next.emplace(key, BookPosition{child, !pos.player, key});
+            }
+        }
+
+        levels.emplace_back();
+        for (const auto& p : next) {
+            levels.back().push_back(p.second);
+        }
+    }
+
+    return levels;
+}
+
+size_t build_book(const State& state, const YGame& game, const Player player, const Cell depth,
+                  const std::string& path, Cache& cache, const uint32_t threads, const BookCallback& progress) {
+
+    const auto cells = game.graph().size();
+
+    std::map<Key, Outcome> solved{};
+
+    BookProgress report{false, 0, 0, 0, 0, player, Outcome::Lose};
+
+    const auto header = book_header(game, canonical_key(state, game, player), depth);
+
+    const bool resume = file_exists(path);
+    if (resume) {
+        for (const auto& entry : load_entries(game, path)) {
+            solved.insert(entry);
+        }
+
+        // The records only fit together below the same root and down to the same depth
+        if (read_file(path).compare(0, header.size(), header) != 0) {
+            throw std::runtime_error("error: book " + path + " was started below a different position or depth");
+        }
+        drop_partial_record(game, path);
+        report.resumed = true;
+        report.loaded = solved.size();
+    }
+
+    std::ofstream out{path, std::ios::binary | std::ios::app};
+    if (!resume) {
+        out << header;
+        out.flush();
+    }
+
+    const auto levels = enumerate(state, game, player, depth);
+
+    // Only the deepest level is searched: every other position follows from its children
+    const auto& deepest = levels.back();
+
+    std::vector<const BookPosition*> todo{};
+    for (const auto& pos : deepest) {
+        if (solved.count(pos.key) == 0) {
+            todo.push_back(&pos);
+        }
+    }
+
+    report.deepest = deepest.size();
+    report.todo = todo.size();
+    if (progress) {
+        progress(report);
+    }
+
+    std::mutex mutex{};
+    std::atomic<size_t> next{0};
+
+    const auto worker = [&](const uint32_t t) {
+        trace_thread("book " + std::to_string(t));
+
+        Search search{game, cache};
+
+        for (auto i = next++; i < todo.size(); i = next++) {
+            const TraceSpan span{"book position", "index", static_cast<int64_t>(i)};
+
+            const auto& pos = *todo.at(i);
+            const auto outcome = solve_outcome(pos.state, search, pos.player);
+
+            std::lock_guard<std::mutex> lock{mutex};
+
+            // Flush each record immediately so nothing is lost if the build is interrupted
+            write_record(out, cells, pos.key, outcome);
+            out.flush();
+            solved[pos.key] = outcome;
+
+            ++report.done;
+            report.player = pos.player;
+            report.outcome = outcome;
+            if (progress) {
+                progress(report);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool{};
+    for (uint32_t t = 0; t < std::max<uint32_t>(threads, 1); ++t) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (size_t d = levels.size() - 1; d-- > 0;) {
+        for (const auto& pos : levels.at(d)) {
+
+            auto outcome = Outcome::Lose;
+
+            for (const auto cell : unique_moves(pos.state, game, pos.player)) {
+
+                State child = pos.state;
+                child.move(game, pos.player, cell);
+
+                if (child.won(cell) || (solved.at(canonical_key(child, game, !pos.player)) == Outcome::Lose)) {
+                    outcome = Outcome::Win;
+                    break;
+                }
+            }
+
+            if (solved.count(pos.key) == 0) {
+                write_record(out, cells, pos.key, outcome);
+                out.flush();
+            }
+
+            solved[pos.key] = outcome;
+        }
+    }
+
+    out.close();
+
+    // Rewrite the records in sorted order, so the book can be binary searched without sorting
+    std::ostringstream book{};
+    book << header;
+    for (const auto& p : solved) {
+        write_record(book, cells, p.first, p.second);
+    }
+    write_file_atomic(path, book.str());
+
+    return solved.size();
+}
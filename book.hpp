@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cache.hpp"
+#include "cell.hpp"
+#include "key.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// Solved positions near the start of the game, keyed by canonical position
+class Book {
+    private:
+    std::vector<std::pair<Key, Outcome>> entries_;
+
+    public:
+    explicit Book(const YGame& game, const std::string& path);
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    bool lookup(const Key& key, Outcome& outcome) const;
+};
+
+// How far a book build has got, reported once before any position is
+// searched and again as each one is solved
+struct BookProgress {
+    // Whether an earlier build was picked up, and how many positions it had
+    bool resumed;
+    size_t loaded;
+
+    // The positions at the deepest level, and how many of them need searching
+    size_t deepest;
+    size_t todo;
+
+    // How many have been searched, and the last for its player to move
+    size_t done;
+    Player player;
+    Outcome outcome;
+};
+
+using BookCallback = std::function<void(const BookProgress&)>;
+
+// Build or resume the book below the position, returning the number of positions written
+size_t build_book(const State& state, const YGame& game, const Player player, const Cell depth,
+                  const std::string& path, Cache& cache, const uint32_t threads,
+                  const BookCallback& progress = BookCallback{});
@@ -0,0 +1,152 @@
+#include "cache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "trace.hpp"
+#include "util.hpp"
+
+// The data word of an entry: a valid bit, the outcome, the number of empty
+// cells, and the high bits of the index hash as a second check on the key
+static constexpr uint64_t valid_bit = 0x1;
+static constexpr uint64_t lose_bit = 0x2;
+static constexpr uint32_t moves_shift = 2;
+static constexpr uint64_t moves_mask = 0xff;
+static constexpr uint32_t hash_shift = 10;
+
+// Independent hashes for choosing the bucket and checking the key
+static constexpr uint64_t index_seed = 0;
+static constexpr uint64_t check_seed = 0x2545f4914f6cdd1d;
+
+static inline uint32_t entry_moves(const uint64_t data) {
+    return static_cast<uint32_t>((data >> moves_shift) & moves_mask);
+}
+
+Cache::Cache(const size_t capacity) {
+
+    // Round up to a power of two so buckets are chosen by masking
+    buckets_ = 1;
+    while (buckets_ * bucket_size < capacity) {
+        buckets_ *= 2;
+    }
+
+    table_.reset(new Entry[buckets_ * bucket_size]);
+    clear();
+}
+
+bool Cache::lookup(const Key& key, Outcome& outcome) const {
+
+    const auto index = hash_key(key, index_seed);
+    const auto check = hash_key(key, check_seed);
+    const auto bucket = &table_[(index & (buckets_ - 1)) * bucket_size];
+
+    for (size_t i = 0; i < bucket_size; ++i) {
+        const auto data = bucket[i].data.load(std::memory_order_relaxed);
+        const auto xored = bucket[i].check.load(std::memory_order_relaxed);
+
+        if ((data & valid_bit) && ((xored ^ data) == check) && ((data >> hash_shift) == (index >> hash_shift))) {
+            outcome = (data & lose_bit) ? Outcome::Lose : Outcome::Win;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Cache::store(const Key& key, const Outcome outcome, const uint32_t moves) {
+
+    const auto index = hash_key(key, index_seed);
+    const auto check = hash_key(key, check_seed);
+    const auto bucket = &table_[(index & (buckets_ - 1)) * bucket_size];
+
+    uint64_t data = valid_bit | (static_cast<uint64_t>(std::min<uint32_t>(moves, moves_mask)) << moves_shift) | ((index >> hash_shift) << hash_shift);
+    if (outcome == Outcome::Lose) {
+        data |= lose_bit;
+    }
+
+    // Replace the same key if present, otherwise an empty entry, otherwise
+    // the entry closest to the end of the game, which is cheapest to redo
+    size_t victim = 0;
+    uint32_t victim_moves = moves_mask + 1;
+
+    for (size_t i = 0; i < bucket_size; ++i) {
+        const auto old = bucket[i].data.load(std::memory_order_relaxed);
+        const auto xored = bucket[i].check.load(std::memory_order_relaxed);
+
+        if (!(old & valid_bit) || ((xored ^ old) == check)) {
+            victim = i;
+            break;
+        }
+
+        if (entry_moves(old) < victim_moves) {
+            victim = i;
+            victim_moves = entry_moves(old);
+        }
+    }
+
+    bucket[victim].check.store(check ^ data, std::memory_order_relaxed);
+    bucket[victim].data.store(data, std::memory_order_relaxed);
+}
+
+void Cache::clear() {
+    const TraceSpan span{"cache clear"};
+    for (size_t i = 0; i < buckets_ * bucket_size; ++i) {
+        table_[i].check.store(0, std::memory_order_relaxed);
+        table_[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Entries are saved in chunks to keep the stream writes large
+static constexpr size_t chunk_entries = 4096;
+
+void Cache::write(std::ostream& os) const {
+
+    const TraceSpan span{"cache write"};
+
+    write_uint(os, capacity(), 8);
+
+    std::string chunk{};
+    chunk.reserve(chunk_entries * 16);
+
+    for (size_t i = 0; i < capacity(); ++i) {
+        const auto check = table_[i].check.load(std::memory_order_relaxed);
+        const auto data = table_[i].data.load(std::memory_order_relaxed);
+
+        for (size_t b = 0; b < 8; ++b) {
+            chunk.push_back(static_cast<char>(check >> (8 * b)));
+        }
+        for (size_t b = 0; b < 8; ++b) {
+            chunk.push_back(static_cast<char>(data >> (8 * b)));
+        }
+
+        if ((chunk.size() >= chunk_entries * 16) || (i + 1 == capacity())) {
+            os.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            chunk.clear();
+        }
+    }
+}
+
+void Cache::read(const std::string& data, size_t& pos) {
+
+    const auto entries = read_uint(data, pos, 8);
+
+    // Saved tables always have a whole number of buckets, a power of two of them
+    const auto buckets = entries / bucket_size;
+    if ((buckets == 0) || ((buckets & (buckets - 1)) != 0) || (buckets * bucket_size != entries)) {
+        throw std::runtime_error("error: invalid cache table");
+    }
+
+    if (pos + entries * 16 > data.size()) {
+        throw std::runtime_error("error: unexpected end of file");
+    }
+
+    if (entries != capacity()) {
+        buckets_ = buckets;
+        table_.reset(new Entry[entries]);
+    }
+
+    for (size_t i = 0; i < entries; ++i) {
+        table_[i].check.store(read_uint(data, pos, 8), std::memory_order_relaxed);
+        table_[i].data.store(read_uint(data, pos, 8), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "cell.hpp"
+#include "key.hpp"
+
+// A table of solved positions shared by all search threads without locks.
+// Each entry is two words written independently, the data and the data
+// xored with a check hash of the key, so an entry torn by a concurrent
+// write fails verification and reads as a miss.
+class Cache {
+    private:
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    // Entries are grouped into buckets of one cache line
+    static constexpr size_t bucket_size = 4;
+
+    std::unique_ptr<Entry[]> table_;
+    size_t buckets_;
+
+    public:
+    explicit Cache(const size_t capacity);
+
+    bool lookup(const Key& key, Outcome& outcome) const;
+
+    // Store the outcome of a position with the given number of empty cells,
+    // which decides which entries are worth keeping when a bucket is full
+    void store(const Key& key, const Outcome outcome, const uint32_t moves);
+
+    void clear();
+
+    size_t capacity() const {
+        return buckets_ * bucket_size;
+    }
+
+    // Save every entry while other threads keep using the table. An entry
+    // changed mid-copy is saved torn and reads back as a miss.
+    void write(std::ostream& os) const;
+
+    // Replace the table with one saved by write, taking on its capacity
+    void read(const std::string& data, size_t& pos);
+};
@@ -0,0 +1,134 @@
+#include "checkpoint.hpp"
+
+#include <vector>
+
+#include "key.hpp"
+#include "trace.hpp"
+#include "util.hpp"
+
+// Format: magic, board fingerprint, number of cells, root position key, the
+// decided root moves as a count and then cell and outcome bytes, then the cache
+static const std::string checkpoint_magic = "YCHECK01";
+
+Checkpointer::Checkpointer(const std::string& path, const std::chrono::seconds interval, const YGame& game,
+                           const State& state, const Player player, const std::map<Cell, Outcome>& moves,
+                           const Cache& cache, const CheckpointFailure& failure)
+    : path_{path}, interval_{interval}, game_{game}, state_{state}, player_{player}, cache_{cache}, failure_{failure},
+      moves_{moves}, mutex_{}, wake_{}, done_{false}, thread_{} {
+    thread_ = std::thread{&Checkpointer::run, this};
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void Checkpointer::record(const MoveResult& move) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    moves_[move.move] = move.outcome;
+}
+
+void Checkpointer::run() {
+
+    trace_thread("checkpoint");
+
+    std::unique_lock<std::mutex> lock{mutex_};
+
+    while (!done_) {
+        if (wake_.wait_for(lock, interval_, [this]() { return done_; })) {
+            return;
+        }
+
+        lock.unlock();
+        try {
+            write();
+        } catch (const std::runtime_error& err) {
+            // A failed checkpoint should not end the solve; the next one may succeed
+            if (failure_) {
+                failure_(err);
+            }
+        }
+        lock.lock();
+    }
+}
+
+void Checkpointer::write() {
+
+    const TraceSpan span{"checkpoint"};
+
+    std::map<Cell, Outcome> moves{};
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        moves = moves_;
+    }
+
+    const auto cells = game_.graph().size();
+
+    write_file_atomic(path_, [&](std::ostream& os) {
+        os << checkpoint_magic;
+        write_uint(os, fingerprint(game_), 8);
+        write_uint(os, cells, 4);
+
+        std::vector<uint8_t> bytes(key_bytes(cells));
+        write_key(position_key(state_, player_), cells, bytes.data());
+        os.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+        write_uint(os, moves.size(), 4);
+        for (const auto& move : moves) {
+            write_uint(os, move.first, 1);
+            write_uint(os, static_cast<uint64_t>(move.second), 1);
+        }
+
+        cache_.write(os);
+    });
+}
+
+std::map<Cell, Outcome> read_checkpoint(const std::string& path, const YGame& game, const State& state,
+                                        const Player player, Cache& cache) {
+
+    const auto data = read_file(path);
+
+    if (data.compare(0, checkpoint_magic.size(), checkpoint_magic) != 0) {
+        throw std::runtime_error("error: not a checkpoint file");
+    }
+
+    size_t pos = checkpoint_magic.size();
+
+    const auto cells = game.graph().size();
+    if ((read_uint(data, pos, 8) != fingerprint(game)) || (read_uint(data, pos, 4) != cells)) {
+        throw std::runtime_error("error: checkpoint was written for a different board");
+    }
+
+    if (pos + key_bytes(cells) > data.size()) {
+        throw std::runtime_error("error: unexpected end of file");
+    }
+
+    const auto key = read_key(reinterpret_cast<const uint8_t*>(data.data() + pos), cells);
+    pos += key_bytes(cells);
+
+    if (key != position_key(state, player)) {
+        throw std::runtime_error("error: checkpoint was written for a different position");
+    }
+
+    std::map<Cell, Outcome> moves{};
+
+    const auto count = read_uint(data, pos, 4);
+    for (uint64_t i = 0; i < count; ++i) {
+        const auto cell = static_cast<Cell>(read_uint(data, pos, 1));
+        const auto outcome = read_uint(data, pos, 1);
+
+        if ((cell >= cells) || (state.board.at(cell).player != Player::None) || (outcome > 1)) {
+            throw std::runtime_error("error: invalid checkpoint move");
+        }
+
+        moves[cell] = static_cast<Outcome>(outcome);
+    }
+
+    cache.read(data, pos);
+
+    return moves;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "cache.hpp"
+#include "cell.hpp"
+#include "negamax.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// Told on the background thread about a checkpoint that could not be written
+using CheckpointFailure = std::function<void(const std::runtime_error&)>;
+
+// Periodically saves how far a solve has got: the root moves decided so far
+// and the whole cache, which holds the proven parts of the subtree being
+// searched. A background thread writes each checkpoint through a temporary
+// file while the search carries on, so the workers are never paused.
+class Checkpointer {
+    private:
+    const std::string path_;
+    const std::chrono::seconds interval_;
+    const YGame& game_;
+    const State state_;
+    const Player player_;
+    const Cache& cache_;
+    const CheckpointFailure failure_;
+
+    std::map<Cell, Outcome> moves_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool done_;
+    std::thread thread_;
+
+    void run();
+
+    public:
+    explicit Checkpointer(const std::string& path, const std::chrono::seconds interval, const YGame& game,
+                          const State& state, const Player player, const std::map<Cell, Outcome>& moves,
+                          const Cache& cache, const CheckpointFailure& failure = CheckpointFailure{});
+
+    // Stops the background thread without writing again
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    void record(const MoveResult& move);
+
+    // Write a checkpoint right away
+    void write();
+};
+
+// Load a checkpoint of the solve of a position, returning the root moves it
+// had decided and replacing the cache with the saved one
+std::map<Cell, Outcome> read_checkpoint(const std::string& path, const YGame& game, const State& state,
+                                        const Player player, Cache& cache);
@@ -0,0 +1,110 @@
+#include "cli.hpp"
+
+#include "util.hpp"
+
+Cell parse_base(const std::string& base_str) {
+
+    auto base = parse_int<Cell>(base_str);
+
+    if (base < 2) {
+        throw std::runtime_error("invalid base: " + base_str);
+    }
+
+    // Cells are represented as uint8_t, so the largest base
+    // we can use right now is 13.
+    if (base > 13) {
+        throw std::runtime_error("base too large: " + base_str);
+    }
+
+    return base;
+}
+
+Player parse_player(const std::string& player_str) {
+
+    if (player_str == "black") {
+        return Player::Black;
+    } else if (player_str == "white") {
+        return Player::White;
+    } else {
+        throw std::runtime_error("invalid player: " + player_str);
+    }
+}
+
+State parse_board(const YGame& game, const std::string& board_str) {
+
+    State state{game};
+
+    std::vector<Player> board{state.board.size(), Player::None};
+
+    const auto moves = split(board_str, ' ');
+
+    for (const auto& move : moves) {
+
+        // The split function skips any empty strings
+        const auto player_chr = move.at(0);
+
+        Player player;
+        if (player_chr == 'B') {
+            player = Player::Black;
+        } else if (player_chr == 'W') {
+            player = Player::White;
+        } else {
+            throw std::runtime_error("invalid player: " + std::string{1, player_chr});
+        }
+
+        const auto label = parse_int<Cell>(move.substr(1));
+
+        if (label >= state.board.size()) {
+            throw std::runtime_error("invalid position: " + std::to_string(label));
+        }
+
+        const auto cell = game.label_cell(label);
+
+        if (board.at(cell) == !player) {
+            throw std::runtime_error("error: conflicting players for cell " + std::to_string(label));
+        }
+
+        board.at(cell) = player;
+    }
+
+    for (Cell cell = 0; cell < board.size(); ++cell) {
+        const auto player = board.at(cell);
+        if (player != Player::None) {
+            state.move(game, player, cell);
+
+            if (state.won(cell)) {
+                throw std::runtime_error("error: initial board cannot be won");
+            }
+        }
+    }
+
+    return state;
+}
+
+Game parse_game(const std::string& game_str) {
+    if (game_str == "geodesic") {
+        return Game::Geodesic;
+    } else if (game_str == "custom") {
+        return Game::Custom;
+    } else {
+        throw std::runtime_error("error: invalid game type " + game_str);
+    }
+}
+
+// Write a position in the notation read by parse_board
+std::string board_string(const YGame& game, const State& state) {
+
+    std::string board_str{};
+    for (Cell label = 0; label < state.board.size(); ++label) {
+        const auto player = state.board.at(game.label_cell(label)).player;
+        if (player != Player::None) {
+            if (!board_str.empty()) {
+                board_str += ' ';
+            }
+            board_str += (player == Player::Black) ? 'B' : 'W';
+            board_str += std::to_string(label);
+        }
+    }
+
+    return board_str;
+}
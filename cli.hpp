@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// Parsing of the command line arguments shared by the solver and the verifier
+
+enum class Game {
+    Geodesic,
+    Custom,
+};
+
+Cell parse_base(const std::string& base_str);
+Player parse_player(const std::string& player_str);
+Game parse_game(const std::string& game_str);
+State parse_board(const YGame& game, const std::string& board_str);
+std::string board_string(const YGame& game, const State& state);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <sstream>
 
 #include "custom.hpp"
@@ -143,7 +144,78 @@ static std::vector<Edge> parse_cell_edges(const std::vector<std::string>& lines,
     return edges;
 }
 
-CustomY::CustomY(const std::string& file_path) {
+// The widest gap between neighbors' numbers, with cell order.at(i) numbered i
+static Cell order_bandwidth(const std::vector<std::vector<Cell>>& graph, const std::vector<Cell>& order) {
+
+    std::vector<Cell> number(graph.size());
+    for (Cell i = 0; i < graph.size(); ++i) {
+        number.at(order.at(i)) = i;
+    }
+
+    Cell bandwidth = 0;
+    for (Cell cell = 0; cell < graph.size(); ++cell) {
+        for (const auto nhbr : graph.at(cell)) {
+            const auto a = number.at(cell);
+            const auto b = number.at(nhbr);
+            bandwidth = std::max<Cell>(bandwidth, (a > b) ? a - b : b - a);
+        }
+    }
+    return bandwidth;
+}
+
+// The Cuthill-McKee order of the cells, started from every edge cell at once:
+// breadth-first in from the edges, visiting neighbors by increasing degree.
+// Each cell's neighbors end up close to it in number, like the rings of a
+// geodesic board. The order is not reversed as usual, which would give the
+// same band, and the search keeps trying moves in the file's order either way.
+static std::vector<Cell> cuthill_mckee(const std::vector<std::vector<Cell>>& graph, const std::vector<Edge>& edges) {
+
+    const auto degree = [&](const Cell cell) {
+        return graph.at(cell).size();
+    };
+
+    std::vector<Cell> order{};
+    std::vector<bool> seen(graph.size(), false);
+
+    for (Cell cell = 0; cell < graph.size(); ++cell) {
+        if (edges.at(cell) != Edge::None) {
+            order.push_back(cell);
+            seen.at(cell) = true;
+        }
+    }
+    std::stable_sort(std::begin(order), std::end(order), [&](const Cell a, const Cell b) {
+        return degree(a) < degree(b);
+    });
+
+    // Cells cut off from every edge are placed last, in the file's order
+    for (size_t next = 0; next < graph.size(); ++next) {
+        if (next == order.size()) {
+            for (Cell cell = 0; cell < graph.size(); ++cell) {
+                if (!seen.at(cell)) {
+                    order.push_back(cell);
+                    seen.at(cell) = true;
+                    break;
+                }
+            }
+        }
+
+        auto nhbrs = graph.at(order.at(next));
+        std::stable_sort(std::begin(nhbrs), std::end(nhbrs), [&](const Cell a, const Cell b) {
+            return degree(a) < degree(b);
+        });
+
+        for (const auto nhbr : nhbrs) {
+            if (!seen.at(nhbr)) {
+                seen.at(nhbr) = true;
+                order.push_back(nhbr);
+            }
+        }
+    }
+
+    return order;
+}
+
+CustomY::CustomY(const std::string& file_path, const bool renumber) {
 
     const auto file = read_file(file_path);
 
@@ -154,6 +226,39 @@ CustomY::CustomY(const std::string& file_path) {
 
     const auto num_board_cells = parse_num_board_cells(lines);
 
-    graph_ = parse_board_graph(lines, num_board_cells);
-    edges_ = parse_cell_edges(lines, num_board_cells);
+    const auto file_graph = parse_board_graph(lines, num_board_cells);
+    const auto file_edges = parse_cell_edges(lines, num_board_cells);
+
+    labels_.resize(num_board_cells);
+    for (Cell cell = 0; cell < num_board_cells; ++cell) {
+        labels_.at(cell) = cell;
+    }
+    file_bandwidth_ = order_bandwidth(file_graph, labels_);
+
+    // Only worth it where the new numbers narrow the band
+    if (renumber) {
+        const auto order = cuthill_mckee(file_graph, file_edges);
+        if (order_bandwidth(file_graph, order) < file_bandwidth_) {
+            labels_ = order;
+        }
+    }
+    bandwidth_ = order_bandwidth(file_graph, labels_);
+
+    cells_.resize(num_board_cells);
+    for (Cell cell = 0; cell < num_board_cells; ++cell) {
+        cells_.at(labels_.at(cell)) = cell;
+    }
+
+    graph_.resize(num_board_cells);
+    edges_.resize(num_board_cells);
+    for (Cell cell = 0; cell < num_board_cells; ++cell) {
+        for (const auto nhbr : file_graph.at(labels_.at(cell))) {
+            graph_.at(cell).push_back(cells_.at(nhbr));
+        }
+        std::sort(std::begin(graph_.at(cell)), std::end(graph_.at(cell)));
+        edges_.at(cell) = file_edges.at(labels_.at(cell));
+    }
+
+    // Board files give no symmetries, so there are no permutations to renumber
+    symmetry_ = Symmetry{perms_, graph_.size()};
 }
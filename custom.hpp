@@ -8,10 +8,23 @@ class CustomY : public YGame {
     private:
     std::vector<std::vector<Cell>> graph_;
     std::vector<std::vector<Cell>> perms_;
+    Symmetry symmetry_;
     std::vector<Edge> edges_;
+    EdgeTemplates templates_;
+
+    // The board file's number for each cell, and the cell for each number
+    std::vector<Cell> labels_;
+    std::vector<Cell> cells_;
+    std::vector<Cell> no_order_;
+
+    // The widest gap between neighbors' numbers, as given and as renumbered
+    Cell file_bandwidth_;
+    Cell bandwidth_;
 
     public:
-    explicit CustomY(const std::string& file_path);
+    // Unless told not to, renumber the cells so that neighbors have nearby
+    // numbers, keeping the file's numbers if that would not narrow the band
+    explicit CustomY(const std::string& file_path, const bool renumber = true);
 
     const std::vector<std::vector<Cell>>& graph() const override {
         return graph_;
@@ -21,7 +34,42 @@ class CustomY : public YGame {
         return perms_;
     }
 
+    const Symmetry& symmetry() const override {
+        return symmetry_;
+    }
+
     Edge cell_edge(Cell cell) const override {
         return edges_.at(cell);
     }
+
+    // No templates are known for boards of arbitrary shape
+    const EdgeTemplates& templates() const override {
+        return templates_;
+    }
+
+    Cell cell_label(const Cell cell) const override {
+        return labels_.at(cell);
+    }
+
+    Cell label_cell(const Cell label) const override {
+        return cells_.at(label);
+    }
+
+    // The new numbers are only for locality, so moves are still tried in the
+    // file's order, which the cell for each number gives
+    const std::vector<Cell>& move_order() const override {
+        return renumbered() ? cells_ : no_order_;
+    }
+
+    Cell file_bandwidth() const {
+        return file_bandwidth_;
+    }
+
+    Cell bandwidth() const {
+        return bandwidth_;
+    }
+
+    bool renumbered() const {
+        return bandwidth_ < file_bandwidth_;
+    }
 };
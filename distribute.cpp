@@ -0,0 +1,479 @@
+#include "distribute.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cache.hpp"
+#include "cli.hpp"
+#include "key.hpp"
+#include "negamax.hpp"
+#include "trace.hpp"
+#include "util.hpp"
+
+static const std::vector<std::string> spool_dirs = {"jobs", "claimed", "results", "cancel"};
+
+// Workers touch their claim on a job this often, and a claim left untouched
+// for the lease belongs to a worker that died, so the job is run again
+static const std::chrono::seconds heartbeat{1};
+static const std::chrono::seconds lease{15};
+
+static std::string outcome_string(const Outcome outcome) {
+    std::ostringstream str{};
+    str << outcome;
+    return str.str();
+}
+
+static std::string fingerprint_string(const YGame& game) {
+    std::ostringstream str{};
+    str << std::hex << fingerprint(game);
+    return str.str();
+}
+
+// A position in the tree above the jobs, which are its leaves
+struct Unit {
+    State state;
+    Player player;
+    size_t parent;
+    Cell move;
+    std::vector<size_t> children;
+    std::string job;
+    bool decided;
+    bool cancelled;
+    Outcome outcome;
+
+    explicit Unit(const State& state_, const Player player_, const size_t parent_, const Cell move_)
+        : state{state_}, player{player_}, parent{parent_}, move{move_}, children{}, job{},
+          decided{false}, cancelled{false}, outcome{Outcome::Lose} {}
+};
+
+class Coordinator {
+    private:
+    const YGame& game_;
+    std::string spool_;
+    std::vector<Unit> units_;
+    size_t jobs_;
+
+    // The last modification time seen on each claim, and when it was seen to
+    // change, timed by this process so that the clocks of other hosts do not matter
+    std::map<std::string, std::pair<uint64_t, std::chrono::steady_clock::time_point>> claims_;
+
+    void expand(const size_t index, const Cell depth);
+    void cancel(const size_t index);
+    void decide(const size_t index, const Outcome outcome);
+    void requeue_stale();
+
+    public:
+    explicit Coordinator(const State& state, const YGame& game, const Player player, const std::string& spool, const Cell split);
+
+    size_t jobs() const {
+        return jobs_;
+    }
+
+    const Unit& root() const {
+        return units_.at(0);
+    }
+
+    const Unit& unit(const size_t index) const {
+        return units_.at(index);
+    }
+
+    // Read any new results, returning whether the root is now solved
+    bool poll(std::set<std::string>& seen);
+};
+
+Coordinator::Coordinator(const State& state, const YGame& game, const Player player, const std::string& spool, const Cell split)
+    : game_{game}, spool_{spool}, units_{}, jobs_{0}, claims_{} {
+
+    const TraceSpan span{"split", "depth", split};
+
+    units_.emplace_back(state, player, 0, 0);
+    expand(0, split);
+
+    // Positions won outright are decided during the split, which may settle
+    // their parents, and even the root, before any job is run
+    for (auto i = units_.size(); (i-- > 0) && !root().decided;) {
+        const auto& unit = units_.at(i);
+        if (unit.decided && unit.job.empty() && unit.children.empty()) {
+            decide(i, unit.outcome);
+        }
+    }
+}
+
+void Coordinator::expand(const size_t index, const Cell depth) {
+
+    // Copy what is needed, since adding units may move this one
+    const State state = units_.at(index).state;
+    const auto player = units_.at(index).player;
+
+    if (depth == 0) {
+        std::ostringstream id{};
+        id.fill('0');
+        id.width(6);
+        id << jobs_++;
+
+        std::ostringstream job{};
+        job << fingerprint_string(game_) << '\n' << player << '\n' << board_string(game_, state) << '\n';
+
+        write_file_atomic(spool_ + "/jobs/" + id.str(), job.str());
+        units_.at(index).job = id.str();
+        return;
+    }
+
+    const auto moves = unique_moves(state, game_, player);
+
+    // A move that wins immediately decides the position without any jobs
+    for (const auto cell : moves) {
+        State child = state;
+        child.move(game_, player, cell);
+
+        if (child.won(cell)) {
+            units_.at(index).decided = true;
+            units_.at(index).outcome = Outcome::Win;
+
+            // Other units keep the move reaching them, which is what gets reported
+            if (index == 0) {
+                units_.at(index).move = cell;
+            }
+            return;
+        }
+    }
+
+    for (const auto cell : moves) {
+        State child = state;
+        child.move(game_, player, cell);
+
+        units_.emplace_back(child, !player, index, cell);
+        units_.at(index).children.push_back(units_.size() - 1);
+        expand(units_.size() - 1, depth - 1);
+    }
+}
+
+// Tell the workers to abandon any jobs below a position that no longer needs them
+void Coordinator::cancel(const size_t index) {
+
+    auto& unit = units_.at(index);
+
+    if (!unit.job.empty() && !unit.decided) {
+        write_file_atomic(spool_ + "/cancel/" + unit.job, "");
+        std::remove((spool_ + "/jobs/" + unit.job).c_str());
+        unit.decided = true;
+        unit.cancelled = true;
+    }
+
+    for (const auto child : unit.children) {
+        cancel(child);
+    }
+}
+
+void Coordinator::decide(const size_t index, const Outcome outcome) {
+
+    auto& unit = units_.at(index);
+    unit.decided = true;
+    unit.outcome = outcome;
+
+    for (const auto child : unit.children) {
+        cancel(child);
+    }
+
+    if (index == 0) {
+        return;
+    }
+
+    const auto parent = unit.parent;
+    if (units_.at(parent).decided) {
+        return;
+    }
+
+    // One losing child means the parent wins, and it loses only if every child wins
+    if (outcome == Outcome::Lose) {
+        decide(parent, Outcome::Win);
+        return;
+    }
+
+    for (const auto child : units_.at(parent).children) {
+        if (!units_.at(child).decided || units_.at(child).cancelled || (units_.at(child).outcome == Outcome::Lose)) {
+            return;
+        }
+    }
+
+    decide(parent, Outcome::Lose);
+}
+
+// Move the jobs whose workers stopped renewing their claim back for another worker
+void Coordinator::requeue_stale() {
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto names = list_dir(spool_ + "/claimed");
+
+    // Forget the claims that finished
+    for (auto it = std::begin(claims_); it != std::end(claims_);) {
+        if (!std::binary_search(std::begin(names), std::end(names), it->first)) {
+            it = claims_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto& name : names) {
+
+        const auto path = spool_ + "/claimed/" + name;
+        const auto mtime = file_mtime(path);
+
+        auto it = claims_.find(name);
+        if ((it == std::end(claims_)) || (it->second.first != mtime)) {
+            claims_[name] = std::make_pair(mtime, now);
+            continue;
+        }
+
+        if ((now - it->second.second < lease) || file_exists(spool_ + "/results/" + name)) {
+            continue;
+        }
+
+        claims_.erase(it);
+
+        for (const auto& unit : units_) {
+            if ((unit.job == name) && !unit.decided) {
+                if (std::rename(path.c_str(), (spool_ + "/jobs/" + name).c_str()) == 0) {
+                    std::cout << "Job " << name << ": requeued after its worker stopped" << std::endl;
+                }
+            }
+        }
+    }
+}
+
+bool Coordinator::poll(std::set<std::string>& seen) {
+
+    for (const auto& name : list_dir(spool_ + "/results")) {
+
+        // Skip results that are still being written
+        if ((name.find(".tmp") != std::string::npos) || (seen.count(name) != 0)) {
+            continue;
+        }
+        seen.insert(name);
+
+        const auto result = trim_copy(read_file(spool_ + "/results/" + name));
+
+        for (size_t i = 0; i < units_.size(); ++i) {
+            if ((units_.at(i).job == name) && !units_.at(i).decided) {
+                const auto outcome = (result == "win") ? Outcome::Win : Outcome::Lose;
+
+                std::cout << "Job " << name << " (" << units_.at(i).player << " to move, board \""
+                          << board_string(game_, units_.at(i).state) << "\"): " << outcome << std::endl;
+
+                decide(i, outcome);
+            }
+        }
+    }
+
+    requeue_stale();
+
+    return root().decided;
+}
+
+static std::vector<pid_t> spawn_workers(const std::vector<std::string>& worker_args, const uint32_t workers) {
+
+    std::vector<pid_t> pids{};
+
+    for (uint32_t i = 0; i < workers; ++i) {
+        const auto pid = fork();
+
+        if (pid == 0) {
+            std::vector<char*> argv{};
+            for (const auto& arg : worker_args) {
+                argv.push_back(const_cast<char*>(arg.c_str()));
+            }
+            argv.push_back(nullptr);
+
+            execv(argv.at(0), argv.data());
+            _exit(EXIT_FAILURE);
+        }
+
+        if (pid < 0) {
+            throw std::runtime_error("error: unable to start a worker process");
+        }
+
+        pids.push_back(pid);
+    }
+
+    return pids;
+}
+
+void run_coordinator(const State& state, const YGame& game, const Player player, const std::string& spool,
+                     const Cell split, const std::vector<std::string>& worker_args, const uint32_t workers) {
+
+    // Start from an empty spool
+    make_dir(spool);
+    std::remove((spool + "/done").c_str());
+    for (const auto& dir : spool_dirs) {
+        make_dir(spool + "/" + dir);
+        for (const auto& name : list_dir(spool + "/" + dir)) {
+            std::remove((spool + "/" + dir + "/" + name).c_str());
+        }
+    }
+
+    Coordinator coordinator{state, game, player, spool, split};
+
+    std::cout << "Split into " << coordinator.jobs() << " jobs in " << spool << std::endl;
+
+    // Solved by the split alone, so there is nothing for workers to do
+    const auto split_only = coordinator.root().decided;
+
+    auto pids = split_only ? std::vector<pid_t>{} : spawn_workers(worker_args, workers);
+    if (!pids.empty()) {
+        std::cout << "Started " << pids.size() << " local workers" << std::endl;
+    }
+
+    std::set<std::string> seen{};
+    while (!split_only && !coordinator.poll(seen)) {
+
+        // With only local workers, give up if they all died
+        if (!pids.empty()) {
+            for (auto it = std::begin(pids); it != std::end(pids);) {
+                int status = 0;
+                if (waitpid(*it, &status, WNOHANG) == *it) {
+                    it = pids.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            if (pids.empty()) {
+                throw std::runtime_error("error: all local workers exited before the root was solved");
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+
+    write_file_atomic(spool + "/done", "");
+
+    const auto& root = coordinator.root();
+
+    if (root.children.empty() && root.job.empty()) {
+        std::cout << "Move " << static_cast<uint32_t>(game.cell_label(root.move)) << ": win" << std::endl;
+    }
+
+    for (const auto child : root.children) {
+        const auto& unit = coordinator.unit(child);
+        if (unit.decided && !unit.cancelled) {
+            std::cout << "Move " << static_cast<uint32_t>(game.cell_label(unit.move)) << ": " << -unit.outcome << std::endl;
+        }
+    }
+
+    std::cout << "Outcome: " << root.outcome << std::endl;
+
+    for (const auto pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+    }
+}
+
+// Stops a thread polling for as long as a job runs, however the job ends,
+// since destroying a thread that has not been joined ends the process
+struct PollGuard {
+    std::atomic<bool>& finished;
+    std::thread& thread;
+
+    ~PollGuard() {
+        finished = true;
+        thread.join();
+    }
+};
+
+static bool run_job(const YGame& game, const std::string& spool, const std::string& name, Cache& cache) {
+
+    const auto lines = split(read_file(spool + "/claimed/" + name), '\n');
+
+    if ((lines.size() < 2) || (lines.at(0) != fingerprint_string(game))) {
+        throw std::runtime_error("error: job " + name + " was written for a different board");
+    }
+
+    const auto player = parse_player(lines.at(1));
+    const auto state = parse_board(game, (lines.size() > 2) ? lines.at(2) : "");
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> finished{false};
+
+    // Watch for the job being cancelled while it is searched, and keep the claim on it alive
+    std::thread watcher{[&]() {
+        auto beat = std::chrono::steady_clock::now();
+        while (!finished) {
+            if (file_exists(spool + "/cancel/" + name) || file_exists(spool + "/done")) {
+                stop = true;
+            }
+            if (std::chrono::steady_clock::now() - beat >= heartbeat) {
+                touch_file(spool + "/claimed/" + name);
+                beat = std::chrono::steady_clock::now();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        }
+    }};
+    const PollGuard guard{finished, watcher};
+
+    Search search{game, cache};
+    search.stop = &stop;
+
+    bool solved = false;
+    try {
+        const TraceSpan span{"job", "id", parse_int<uint32_t>(name)};
+
+        const auto outcome = solve_outcome(state, search, player);
+        write_file_atomic(spool + "/results/" + name, outcome_string(outcome) + "\n");
+        std::cout << "Job " << name << ": " << outcome << std::endl;
+        solved = true;
+    } catch (const Stopped&) {
+        std::cout << "Job " << name << ": cancelled" << std::endl;
+    }
+
+    return solved;
+}
+
+void run_worker(const YGame& game, const std::string& spool, const size_t cache_size) {
+
+    Cache cache{cache_size};
+
+    // Wait for the coordinator to create the spool
+    while (!file_exists(spool + "/jobs") && !file_exists(spool + "/done")) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    }
+
+    while (!file_exists(spool + "/done")) {
+
+        bool claimed = false;
+
+        for (const auto& name : list_dir(spool + "/jobs")) {
+            if (name.find(".tmp") != std::string::npos) {
+                continue;
+            }
+
+            // Renaming is atomic, so exactly one worker claims each job
+            if (std::rename((spool + "/jobs/" + name).c_str(), (spool + "/claimed/" + name).c_str()) != 0) {
+                continue;
+            }
+
+            claimed = true;
+
+            if (!file_exists(spool + "/cancel/" + name)) {
+                run_job(game, spool, name, cache);
+            }
+
+            // Finished with, so there is no claim left to renew
+            std::remove((spool + "/claimed/" + name).c_str());
+
+            break;
+        }
+
+        if (!claimed) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+    }
+}
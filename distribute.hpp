@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// Solving across processes, possibly on other hosts, through a spool directory:
+//
+//   jobs/<id>     positions waiting for a worker, claimed by renaming them into claimed/
+//   claimed/<id>  jobs being solved, touched by their worker as a heartbeat and
+//                 moved back to jobs/ by the coordinator once it stops
+//   results/<id>  the outcome of a finished job for its player to move
+//   cancel/<id>   jobs whose result is no longer needed, which workers abandon
+//   done          created once the root is solved, telling the workers to exit
+//
+// Jobs hold the position in the --board notation, so any worker started
+// with the same game can solve them.
+
+void run_coordinator(const State& state, const YGame& game, const Player player, const std::string& spool,
+                     const Cell split, const std::vector<std::string>& worker_args, const uint32_t workers);
+
+void run_worker(const YGame& game, const std::string& spool, const size_t cache_size);
@@ -0,0 +1,215 @@
+#include "endgame.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "bits.hpp"
+
+// The empty cells of a position, reduced to a graph of their own. Two empty
+// cells are joined if they are neighbors or touch the same black group, and
+// each one reaches the edges of the black groups it touches.
+struct Endgame {
+    uint32_t size;
+    std::array<uint8_t, endgame_max_moves> adjacent;
+    std::array<uint8_t, endgame_max_moves> edges;
+
+    // Whether black connects the three edges, by the mask of empty cells black fills
+    Bits black_wins;
+
+    // For each partial filling, by base 3 digits: 0 unknown, 1 the player to move wins, 2 they lose
+    std::vector<uint8_t> memo;
+    std::array<uint32_t, endgame_max_moves> powers;
+};
+
+static Endgame reduce(const State& state, const YGame& game) {
+
+    // Bits has its own constructor, so the rest is zeroed by hand
+    Endgame endgame;
+    endgame.size = 0;
+    endgame.adjacent.fill(0);
+    endgame.edges.fill(0);
+
+    // Path compression changes the state, so find the groups in a copy
+    State groups = state;
+
+    // The empty cells in the board's move order, which the search below tries them in
+    const auto& order = game.move_order();
+
+    std::array<int32_t, 256> index{};
+    index.fill(-1);
+    std::array<Cell, endgame_max_moves> cells{};
+    for (Cell i = 0; i < state.board.size(); ++i) {
+        const auto cell = order.empty() ? i : order.at(i);
+        if (state.board.at(cell).player == Player::None) {
+            index.at(cell) = endgame.size;
+            cells.at(endgame.size++) = cell;
+        }
+    }
+
+    // The empty cells touching each black group, by the group's root
+    std::array<uint8_t, 256> touching{};
+
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        const auto cell = cells.at(i);
+        endgame.edges.at(i) = static_cast<uint8_t>(state.board.at(cell).edge);
+
+        for (const auto nhbr : game.graph().at(cell)) {
+            const auto owner = state.board.at(nhbr).player;
+            if (owner == Player::None) {
+                endgame.adjacent.at(i) |= 1 << index.at(nhbr);
+            } else if (owner == Player::Black) {
+                const auto root = groups.root(nhbr);
+                touching.at(root) |= 1 << i;
+                endgame.edges.at(i) |= static_cast<uint8_t>(groups.board.at(root).edge);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        for (const auto nhbr : game.graph().at(cells.at(i))) {
+            if (state.board.at(nhbr).player == Player::Black) {
+                endgame.adjacent.at(i) |= touching.at(groups.root(nhbr));
+            }
+        }
+        endgame.adjacent.at(i) &= ~(1 << i);
+    }
+
+    return endgame;
+}
+
+// The fillings where black holds empty cell i, as a set of masks: bit m is
+// set when bit i of m is, so every filling is handled at once in one lane
+static Bits filled_by(const uint32_t i) {
+    Bits lanes{};
+    for (uint32_t mask = 0; mask < (1u << endgame_max_moves); ++mask) {
+        if ((mask >> i) & 1) {
+            lanes.set(mask);
+        }
+    }
+    return lanes;
+}
+
+// The black cells of each filling connected to seeds through the black
+// cells, spread one step at a time over the graph until nothing changes
+static void flood(const Endgame& endgame, const std::array<Bits, endgame_max_moves>& black,
+                  std::array<Bits, endgame_max_moves>& reach) {
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (uint32_t i = 0; i < endgame.size; ++i) {
+            auto next = reach.at(i);
+            for (auto adjacent = endgame.adjacent.at(i); adjacent != 0; adjacent &= adjacent - 1) {
+                next |= reach.at(__builtin_ctz(adjacent));
+            }
+            next &= black.at(i);
+
+            if (!(next == reach.at(i))) {
+                reach.at(i) = next;
+                changed = true;
+            }
+        }
+    }
+}
+
+// The winner of every filling of the empty cells at once, by a bit-parallel
+// connectivity sweep: the groups touching the right edge, then those of
+// them also touching the left edge, then whether any touches the bottom
+static Bits black_wins(const Endgame& endgame) {
+
+    static const std::array<Bits, endgame_max_moves> lanes = []() {
+        std::array<Bits, endgame_max_moves> all;
+        for (uint32_t i = 0; i < endgame_max_moves; ++i) {
+            all.at(i) = filled_by(i);
+        }
+        return all;
+    }();
+
+    const auto touches = [&](const uint32_t i, const Edge edge) {
+        return (endgame.edges.at(i) & static_cast<uint8_t>(edge)) != 0;
+    };
+
+    std::array<Bits, endgame_max_moves> reach;
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        if (touches(i, Edge::Right)) {
+            reach.at(i) = lanes.at(i);
+        }
+    }
+    flood(endgame, lanes, reach);
+
+    const auto right = reach;
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        reach.at(i) = touches(i, Edge::Left) ? right.at(i) : Bits{};
+    }
+    flood(endgame, right, reach);
+
+    Bits wins{};
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        if (touches(i, Edge::Bottom)) {
+            wins |= reach.at(i);
+        }
+    }
+
+    return wins;
+}
+
+// Whether the player to move wins once the remaining cells are filled in
+// turn, given the cells filled so far and which of them are black
+static bool wins(Endgame& endgame, const uint32_t filled, const uint32_t black, const uint32_t digits, const Player player) {
+
+    const auto full = (1u << endgame.size) - 1;
+
+    if (filled == full) {
+        return endgame.black_wins.test(black) == (player == Player::Black);
+    }
+
+    auto& memo = endgame.memo.at(digits);
+    if (memo != 0) {
+        return memo == 1;
+    }
+
+    bool win = false;
+    for (uint32_t empty = full & ~filled; empty != 0; empty &= empty - 1) {
+
+        const auto i = __builtin_ctz(empty);
+        const auto bit = 1u << i;
+
+        const auto is_black = (player == Player::Black);
+        const auto child_black = is_black ? (black | bit) : black;
+        const auto child_digits = digits + endgame.powers.at(i) * (is_black ? 1 : 2);
+
+        if (!wins(endgame, filled | bit, child_black, child_digits, !player)) {
+            win = true;
+            break;
+        }
+    }
+
+    memo = win ? 1 : 2;
+    return win;
+}
+
+Outcome endgame_outcome(const State& state, const YGame& game, const Player player) {
+
+    // Checked before reducing, which has room for no more than this
+    const auto empty = static_cast<uint32_t>(std::count_if(std::begin(state.board), std::end(state.board),
+                                                            [](const Node& node) { return node.player == Player::None; }));
+    if (empty > endgame_max_moves) {
+        throw std::runtime_error("endgame_outcome: too many empty cells");
+    }
+
+    auto endgame = reduce(state, game);
+
+    endgame.black_wins = black_wins(endgame);
+
+    uint32_t states = 1;
+    for (uint32_t i = 0; i < endgame.size; ++i) {
+        endgame.powers.at(i) = states;
+        states *= 3;
+    }
+    endgame.memo.assign(states, 0);
+
+    return wins(endgame, 0, 0, 0, player) ? Outcome::Win : Outcome::Lose;
+}
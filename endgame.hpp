@@ -0,0 +1,17 @@
+#pragma once
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// The most empty cells the endgame solver handles, so that every filling fits
+// in a byte and the table of partial fillings stays small
+constexpr uint32_t endgame_max_moves = 8;
+
+// Decide a position with at most endgame_max_moves empty cells without making
+// moves on the board. Connections never break and Y has no draws, so the
+// winner is the player who connects on the filled board no matter when they
+// first did. Black's wins are tabled over every way of filling the empty
+// cells, then both players choose cells in turn over the table of partial
+// fillings.
+Outcome endgame_outcome(const State& state, const YGame& game, const Player player);
@@ -0,0 +1,252 @@
+#include "engine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include "negamax.hpp"
+
+// Larger than any real distance, but small enough that sums do not overflow
+static constexpr int32_t unreachable = 1 << 16;
+
+// The two-distance from every cell to one edge for player. A cell touching the
+// edge is one move away, a stone of player's own costs nothing, and any other
+// empty cell is one more than its second closest neighbor, since the opponent
+// can always block the closest. Stones of the opponent are never reachable.
+static void edge_distance(const State& state, const YGame& game, const Player player,
+                          const Edge edge, std::vector<int32_t>& dist) {
+
+    const auto& graph = game.graph();
+    const auto cells = state.board.size();
+
+    dist.assign(cells, unreachable);
+
+    // The rule is monotone in the neighbor distances, so relaxing from above
+    // until nothing changes reaches the fixed point
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (Cell cell = 0; cell < cells; ++cell) {
+
+            const auto owner = state.board.at(cell).player;
+            if (owner == !player) {
+                continue;
+            }
+
+            const auto cost = (owner == player) ? 0 : 1;
+            const auto touches = (static_cast<uint8_t>(game.cell_edge(cell)) & static_cast<uint8_t>(edge)) != 0;
+
+            int32_t best = touches ? cost : unreachable;
+
+            int32_t first = unreachable;
+            int32_t second = unreachable;
+            for (const auto nhbr : graph.at(cell)) {
+                const auto d = dist.at(nhbr);
+                if (d < first) {
+                    second = first;
+                    first = d;
+                } else if (d < second) {
+                    second = d;
+                }
+            }
+
+            // A stone is joined to its neighbors outright, while an empty cell
+            // needs two ways in
+            const auto through = (owner == player) ? first : second;
+            if (through < unreachable) {
+                best = std::min(best, through + cost);
+            }
+
+            if (best < dist.at(cell)) {
+                dist.at(cell) = best;
+                changed = true;
+            }
+        }
+    }
+}
+
+// The fewest moves player needs to join all three edges through a single cell
+static int32_t y_distance(const State& state, const YGame& game, const Player player) {
+
+    std::array<std::vector<int32_t>, 3> dist{};
+    edge_distance(state, game, player, Edge::Right, dist.at(0));
+    edge_distance(state, game, player, Edge::Bottom, dist.at(1));
+    edge_distance(state, game, player, Edge::Left, dist.at(2));
+
+    int32_t best = unreachable;
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+
+        const auto owner = state.board.at(cell).player;
+        if (owner == !player) {
+            continue;
+        }
+
+        // The cell itself is counted once for each edge
+        const auto cost = (owner == player) ? 0 : 1;
+        const auto total = dist.at(0).at(cell) + dist.at(1).at(cell) + dist.at(2).at(cell) - 2 * cost;
+
+        best = std::min(best, total);
+    }
+
+    return best;
+}
+
+int32_t evaluate(const State& state, const YGame& game, const Player player) {
+
+    const auto mine = y_distance(state, game, player);
+    const auto theirs = y_distance(state, game, !player);
+
+    // With no draws in Y, a player who can no longer connect has lost, though
+    // without knowing how many moves it takes
+    if (theirs >= unreachable) {
+        return win_score / 2;
+    } else if (mine >= unreachable) {
+        return -win_score / 2;
+    }
+
+    return theirs - mine;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Engine {
+    const YGame& game;
+    Clock::time_point deadline;
+
+    // Whether the deadline applies, which it does not for the first iteration
+    bool timed;
+
+    // The last move to cause a cutoff at each distance from the root
+    std::vector<Cell> killers;
+};
+
+static std::vector<Cell> empty_cells(const State& state) {
+    std::vector<Cell> cells{};
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        if (state.board.at(cell).player == Player::None) {
+            cells.push_back(cell);
+        }
+    }
+    return cells;
+}
+
+static int32_t alphabeta(const State& state, Engine& engine, const Player player,
+                         const Cell depth, int32_t alpha, const int32_t beta, const Cell ply) {
+
+    if (depth == 0) {
+        return evaluate(state, engine.game, player);
+    }
+
+    if (engine.timed && (Clock::now() >= engine.deadline)) {
+        throw Stopped{};
+    }
+
+    auto moves = empty_cells(state);
+
+    // Try the killer first
+    const auto killer = engine.killers.at(ply);
+    const auto it = std::find(std::begin(moves), std::end(moves), killer);
+    if (it != std::end(moves)) {
+        std::rotate(std::begin(moves), it, it + 1);
+    }
+
+    int32_t best = -win_score;
+
+    State child = state;
+    for (const auto cell : moves) {
+
+        child = state;
+        child.move(engine.game, player, cell);
+
+        if (child.won(cell)) {
+            return win_score - ply - 1;
+        }
+
+        const auto score = -alphabeta(child, engine, !player, depth - 1, -beta, -alpha, ply + 1);
+
+        if (score > best) {
+            best = score;
+        }
+
+        if (best > alpha) {
+            alpha = best;
+        }
+
+        if (alpha >= beta) {
+            engine.killers.at(ply) = cell;
+            break;
+        }
+    }
+
+    return best;
+}
+
+Choice best_move(const State& state, const YGame& game, const Player player,
+                 const Cell max_depth, const std::chrono::milliseconds budget, const DepthProgress& progress) {
+
+    auto moves = empty_cells(state);
+    if (moves.empty()) {
+        throw std::runtime_error("error: the board is full");
+    }
+
+    const auto limit = (max_depth == 0) ? moves.size() : std::min<size_t>(max_depth, moves.size());
+
+    Engine engine{game, Clock::now() + budget, false, std::vector<Cell>(state.board.size() + 1, 0)};
+
+    // Sorted by the last iteration's scores, best first
+    std::vector<std::pair<int32_t, Cell>> scored{};
+    for (const auto cell : moves) {
+        scored.emplace_back(0, cell);
+    }
+
+    Choice choice{moves.front(), 0, 0};
+
+    for (Cell depth = 1; depth <= limit; ++depth) {
+
+        std::vector<std::pair<int32_t, Cell>> next{};
+        int32_t alpha = -win_score;
+
+        try {
+            State child = state;
+            for (const auto& entry : scored) {
+
+                const auto cell = entry.second;
+
+                child = state;
+                child.move(game, player, cell);
+
+                // Moves below the best so far only need to be shown worse
+                const auto score = child.won(cell) ? win_score - 1
+                                 : -alphabeta(child, engine, !player, depth - 1, -win_score, -alpha, 1);
+
+                next.emplace_back(score, cell);
+                alpha = std::max(alpha, score);
+            }
+        } catch (const Stopped&) {
+            break;
+        }
+
+        std::stable_sort(std::begin(next), std::end(next), [](const std::pair<int32_t, Cell>& a,
+                                                              const std::pair<int32_t, Cell>& b) {
+            return a.first > b.first;
+        });
+        scored = next;
+
+        choice = Choice{scored.front().second, scored.front().first, depth};
+
+        if (progress) {
+            progress(choice);
+        }
+
+        // Nothing deeper can change a decided game
+        if (std::abs(choice.score) > win_score - static_cast<int32_t>(limit) - 1) {
+            break;
+        }
+
+        engine.timed = true;
+    }
+
+    return choice;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// Scores are from the point of view of the player to move. A forced win is
+// worth win_score less the number of moves it takes to get there.
+constexpr int32_t win_score = 1000000;
+
+// The move picked by the heuristic engine, and how deep it looked
+struct Choice {
+    Cell move;
+    int32_t score;
+    Cell depth;
+};
+
+// The two-distance evaluation: how much closer player is than the opponent to
+// joining all three edges, counting a cell as reachable once it is two-sided
+int32_t evaluate(const State& state, const YGame& game, const Player player);
+
+// Called with the best move so far as each iteration completes
+using DepthProgress = std::function<void(const Choice&)>;
+
+// Iterative-deepening alpha-beta on the evaluation. Stops after max_depth moves
+// (0 for no limit) or once the time budget runs out, whichever comes first,
+// and always completes at least the first iteration.
+Choice best_move(const State& state, const YGame& game, const Player player,
+                 const Cell max_depth, const std::chrono::milliseconds budget,
+                 const DepthProgress& progress = DepthProgress{});
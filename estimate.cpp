@@ -0,0 +1,174 @@
+#include "estimate.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "endgame.hpp"
+#include "negamax.hpp"
+#include "trace.hpp"
+
+// Each probe is solved on its own, with a cache cleared in between
+static constexpr size_t probe_cache_size = 1 << 18;
+
+// Smaller positions are decided by the endgame solver in one step and say nothing about growth
+static constexpr Cell min_empty = endgame_max_moves + 1;
+
+// How often to retry a probe that ends the game before reaching its size
+static constexpr uint32_t max_tries = 100;
+
+// An interval wider than this factor from end to end says little about the solve
+static constexpr double max_spread = 100;
+
+static std::vector<Cell> empty_cells(const State& state) {
+    std::vector<Cell> cells{};
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        if (state.board.at(cell).player == Player::None) {
+            cells.push_back(cell);
+        }
+    }
+    return cells;
+}
+
+// Play random moves from the position until size empty cells are left. Fails
+// if someone wins on the way, since then there is nothing left to solve.
+static bool random_probe(State& pos, Player& turn, const YGame& game, const size_t size, std::mt19937_64& rng) {
+
+    auto cells = empty_cells(pos);
+    std::shuffle(std::begin(cells), std::end(cells), rng);
+
+    while (cells.size() > size) {
+        const auto cell = cells.back();
+        cells.pop_back();
+
+        pos.move(game, turn, cell);
+        if (pos.won(cell)) {
+            return false;
+        }
+
+        turn = !turn;
+    }
+
+    return true;
+}
+
+// Fit ys as a line in xs and extrapolate it to x0, undoing the logarithm,
+// along with the 95% prediction interval of the regression there: where one
+// more sample at x0 would fall, not just where the fitted line runs
+static void extrapolate(const std::vector<double>& xs, const std::vector<double>& ys, const double x0,
+                        double& value, double& low, double& high) {
+
+    const auto n = static_cast<double>(xs.size());
+
+    double mean_x = 0;
+    double mean_y = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        mean_x += xs.at(i) / n;
+        mean_y += ys.at(i) / n;
+    }
+
+    double sxx = 0;
+    double sxy = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        sxx += (xs.at(i) - mean_x) * (xs.at(i) - mean_x);
+        sxy += (xs.at(i) - mean_x) * (ys.at(i) - mean_y);
+    }
+
+    // With a single size there is no growth to fit
+    const auto slope = (sxx > 0) ? sxy / sxx : 0;
+    const auto intercept = mean_y - slope * mean_x;
+
+    double sse = 0;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        const auto residual = ys.at(i) - (intercept + slope * xs.at(i));
+        sse += residual * residual;
+    }
+
+    const auto y0 = intercept + slope * x0;
+    const auto s = (n > 2) ? std::sqrt(sse / (n - 2)) : 0;
+    const auto spread = (sxx > 0) ? (x0 - mean_x) * (x0 - mean_x) / sxx : 0;
+    const auto half = 1.96 * s * std::sqrt(1 + 1 / n + spread);
+
+    value = std::exp(y0);
+    low = std::exp(y0 - half);
+    high = std::exp(y0 + half);
+}
+
+Estimate estimate_tree(const State& state, const YGame& game, const Player player,
+                       const uint32_t probes, const Cell frontier, const uint64_t seed) {
+
+    using Clock = std::chrono::steady_clock;
+
+    // A line needs at least two sizes to be fitted through
+    if (frontier <= min_empty) {
+        throw std::runtime_error("error: the frontier must be at least " + std::to_string(min_empty + 1)
+                                 + " empty cells, since smaller probes are decided without a search");
+    }
+
+    const auto root_empty = empty_cells(state).size();
+
+    // The sizes to solve at, never larger than the position itself
+    const auto top = std::min<size_t>(frontier, root_empty);
+    const auto bottom = std::min<size_t>(min_empty, top);
+
+    std::mt19937_64 rng{seed};
+    Cache cache{probe_cache_size};
+
+    // Empty cells, and log node count and time, of each probe solved
+    std::vector<double> xs{};
+    std::vector<double> node_logs{};
+    std::vector<double> time_logs{};
+
+    const auto sizes = top - bottom + 1;
+    for (uint32_t i = 0; i < std::max<uint32_t>(probes, 1); ++i) {
+
+        const auto size = bottom + i % sizes;
+
+        State pos = state;
+        Player turn = player;
+
+        uint32_t tries = 0;
+        while (!random_probe(pos, turn, game, size, rng) && (++tries < max_tries)) {
+            pos = state;
+            turn = player;
+        }
+        if (tries == max_tries) {
+            continue;
+        }
+
+        const TraceSpan span{"probe", "empty", static_cast<int64_t>(size)};
+
+        cache.clear();
+        Search search{game, cache};
+
+        const auto start = Clock::now();
+        solve_outcome(pos, search, turn);
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+        xs.push_back(size);
+        node_logs.push_back(std::log(std::max<double>(search.nodes, 1)));
+        time_logs.push_back(std::log(std::max(elapsed.count(), 1e-9)));
+    }
+
+    Estimate est{};
+    est.samples = xs.size();
+
+    if (xs.empty()) {
+        return est;
+    }
+
+    const auto x0 = static_cast<double>(root_empty);
+    extrapolate(xs, node_logs, x0, est.nodes, est.nodes_low, est.nodes_high);
+    extrapolate(xs, time_logs, x0, est.seconds, est.seconds_low, est.seconds_high);
+
+    // Solving the position searches at least the position itself
+    est.nodes_low = std::max(est.nodes_low, 1.0);
+    est.wide = est.nodes_high > max_spread * est.nodes_low;
+
+    return est;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// The predicted cost of solving a position on one thread, with the 95%
+// prediction interval of the regression, fitted to the given number of probes.
+// With no samples there is no prediction, and every other field is zero.
+struct Estimate {
+    uint32_t samples;
+    double nodes;
+    double nodes_low;
+    double nodes_high;
+    double seconds;
+    double seconds_low;
+    double seconds_high;
+
+    // Whether the interval spans more than a factor of 100, too wide to mean much
+    bool wide;
+};
+
+// Estimate the cost of solving a position by solving smaller ones. Random
+// probes play on from the position to every size from just above what the
+// endgame solver decides up to frontier empty cells, which must be at least 10.
+// The actual search solves each probe, and the logarithms of its node count
+// and time are fitted as lines in the number of empty cells and extrapolated
+// back to the position itself. This measures the search as it runs, cutoffs,
+// cache and symmetry pruning included, rather than the size of the full game tree.
+Estimate estimate_tree(const State& state, const YGame& game, const Player player,
+                       const uint32_t probes, const Cell frontier, const uint64_t seed);
@@ -22,11 +22,12 @@ static inline Cell left_cell(const Cell base) {
   return right_cell(base) + base - 1;
 }
 
-Edge GeodesicY::cell_edge(const Cell cell) const {
+// The sides of the given ring that a cell of it lies on, named by the edge they face
+static Edge ring_side(const Cell cell, const Cell ring) {
 
-    const auto top = top_cell(base);
-    const auto right = right_cell(base);
-    const auto left = left_cell(base);
+    const auto top = top_cell(ring);
+    const auto right = right_cell(ring);
+    const auto left = left_cell(ring);
 
     auto edge = Edge::None;
     if ((top <= cell) && (cell <= right)) {
@@ -44,6 +45,10 @@ Edge GeodesicY::cell_edge(const Cell cell) const {
     return edge;
 }
 
+Edge GeodesicY::cell_edge(const Cell cell) const {
+    return ring_side(cell, base);
+}
+
 // The adjacency graph for the board
 static std::vector<std::vector<Cell>> gen_graph(const Cell base) {
 
@@ -201,9 +206,79 @@ static std::vector<std::vector<Cell>> gen_perms(const Cell base) {
     return {rot, rotrot, ref, rotref, rotrotref};
 }
 
+// Templates start on the two rings inside the edge. A stone there may use its
+// neighbors on its own ring, and the cells of each outer ring at most one
+// step aside from straight out, which is all the known edge templates of
+// that height need.
+static std::vector<TemplateSite> gen_sites(const std::vector<std::vector<Cell>>& graph, const Cell base) {
+
+    std::vector<Cell> ring_of(board_size(base));
+    for (Cell ring = 2; ring <= base; ++ring) {
+        for (Cell cell = top_cell(ring); cell < board_size(ring); ++cell) {
+            ring_of.at(cell) = ring;
+        }
+    }
+
+    std::vector<TemplateSite> sites{};
+
+    for (Cell ring = std::max(base - 2, 2); ring < base; ++ring) {
+        for (Cell cell = top_cell(ring); cell < board_size(ring); ++cell) {
+            for (const auto edge : {Edge::Right, Edge::Bottom, Edge::Left}) {
+
+                const auto facing = [&](const Cell other) {
+                    return (static_cast<uint8_t>(ring_side(other, ring_of.at(other))) & static_cast<uint8_t>(edge)) != 0;
+                };
+
+                if (!facing(cell)) {
+                    continue;
+                }
+
+                // Distances from the stone through the outer cells facing the edge
+                std::vector<uint32_t> dist(graph.size(), 0);
+                std::vector<Cell> frontier{cell};
+                std::vector<Cell> region{};
+
+                for (uint32_t step = 1; !frontier.empty(); ++step) {
+                    std::vector<Cell> next{};
+                    for (const auto from : frontier) {
+                        for (const auto nhbr : graph.at(from)) {
+                            if ((nhbr == cell) || (dist.at(nhbr) != 0) || (ring_of.at(nhbr) < ring)) {
+                                continue;
+                            }
+                            dist.at(nhbr) = step;
+
+                            if (ring_of.at(nhbr) == ring) {
+                                if (step == 1) {
+                                    region.push_back(nhbr);
+                                }
+                            } else if (facing(nhbr) && (step <= ring_of.at(nhbr) - ring + 1u)) {
+                                region.push_back(nhbr);
+                                next.push_back(nhbr);
+                            }
+                        }
+                    }
+                    frontier = next;
+                }
+
+                std::sort(std::begin(region), std::end(region));
+                sites.push_back(TemplateSite{cell, edge, region});
+            }
+        }
+    }
+
+    return sites;
+}
+
 GeodesicY::GeodesicY(const Cell base_) {
     base = base_;
     graph_ = gen_graph(base);
     perms_ = gen_perms(base);
+    symmetry_ = Symmetry{perms_, graph_.size()};
+
+    std::vector<Edge> edges{};
+    for (Cell cell = 0; cell < graph_.size(); ++cell) {
+        edges.push_back(cell_edge(cell));
+    }
+    templates_ = EdgeTemplates{graph_, edges, gen_sites(graph_, base)};
 }
 
@@ -7,6 +7,8 @@ class GeodesicY : public YGame {
     Cell base;
     std::vector<std::vector<Cell>> graph_;
     std::vector<std::vector<Cell>> perms_;
+    Symmetry symmetry_;
+    EdgeTemplates templates_;
 
     public:
     explicit GeodesicY(const Cell base_);
@@ -19,5 +21,13 @@ class GeodesicY : public YGame {
         return perms_;
     }
 
+    const Symmetry& symmetry() const override {
+        return symmetry_;
+    }
+
     Edge cell_edge(Cell cell) const override;
+
+    const EdgeTemplates& templates() const override {
+        return templates_;
+    }
 };
@@ -0,0 +1,180 @@
+#include "key.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static inline uint64_t mix(uint64_t x) {
+    // The splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t hash_key(const Key& key, const uint64_t seed) {
+
+    uint64_t h = seed;
+    for (const auto word : key.words) {
+        h = mix(h ^ word) + 0x9e3779b97f4a7c15;
+    }
+
+    return h;
+}
+
+Board players(const State& state) {
+
+    Board board{};
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        board[cell] = static_cast<uint8_t>(state.board.at(cell).player);
+    }
+
+    return board;
+}
+
+// The canonical child positions of every move, packed one after another, and
+// the moves reaching them sorted by canonical position, equal ones in cell order
+static void sorted_children(const State& state, const YGame& game, const Player player,
+                            std::vector<uint8_t>& children, std::vector<std::pair<size_t, Cell>>& moves) {
+
+    const auto cells = state.board.size();
+    const auto& symmetry = game.symmetry();
+
+    auto board = players(state);
+
+    Board canon{};
+    for (Cell cell = 0; cell < cells; ++cell) {
+        if (state.board.at(cell).player == Player::None) {
+            board[cell] = static_cast<uint8_t>(player);
+
+            symmetry.canonicalize(board, canon);
+            children.insert(std::end(children), std::begin(canon), std::begin(canon) + cells);
+            moves.emplace_back(moves.size(), cell);
+
+            board[cell] = static_cast<uint8_t>(Player::None);
+        }
+    }
+
+    const auto child = [&](const std::pair<size_t, Cell>& move) {
+        return children.data() + move.first * cells;
+    };
+
+    std::stable_sort(std::begin(moves), std::end(moves), [&](const std::pair<size_t, Cell>& a, const std::pair<size_t, Cell>& b) {
+        return std::memcmp(child(a), child(b), cells) < 0;
+    });
+}
+
+std::vector<std::vector<Cell>> move_orbits(const State& state, const YGame& game, const Player player) {
+
+    const auto cells = state.board.size();
+
+    std::vector<uint8_t> children{};
+    std::vector<std::pair<size_t, Cell>> moves{};
+    sorted_children(state, game, player, children, moves);
+
+    const auto child = [&](const size_t i) {
+        return children.data() + moves.at(i).first * cells;
+    };
+
+    std::vector<std::vector<Cell>> orbits{};
+    for (size_t i = 0; i < moves.size(); ++i) {
+        const bool first = (i == 0) || (std::memcmp(child(i - 1), child(i), cells) != 0);
+        if (first) {
+            orbits.emplace_back();
+        }
+        orbits.back().push_back(moves.at(i).second);
+    }
+
+    return orbits;
+}
+
+std::vector<Cell> unique_moves(const State& state, const YGame& game, const Player player) {
+
+    const auto cells = state.board.size();
+
+    std::vector<uint8_t> children{};
+    std::vector<std::pair<size_t, Cell>> moves{};
+    sorted_children(state, game, player, children, moves);
+
+    const auto child = [&](const size_t i) {
+        return children.data() + moves.at(i).first * cells;
+    };
+
+    // Keep the later move among equal ones
+    std::vector<Cell> unique{};
+    for (size_t i = 0; i < moves.size(); ++i) {
+        const bool last = (i + 1 == moves.size()) || (std::memcmp(child(i), child(i + 1), cells) != 0);
+        if (last) {
+            unique.push_back(moves.at(i).second);
+        }
+    }
+
+    return unique;
+}
+
+Key make_key(const Board& board, const size_t cells, const Player player) {
+
+    Key key{};
+    key.set(0, player);
+
+    for (uint32_t cell = 0; cell < cells; ++cell) {
+        key.set(cell + 1, static_cast<Player>(board[cell]));
+    }
+
+    return key;
+}
+
+Key position_key(const State& state, const Player player) {
+
+    Key key{};
+    key.set(0, player);
+
+    for (uint32_t cell = 0; cell < state.board.size(); ++cell) {
+        key.set(cell + 1, state.board.at(cell).player);
+    }
+
+    return key;
+}
+
+Key canonical_key(const State& state, const YGame& game, const Player player) {
+    Board canon{};
+    game.symmetry().canonicalize(players(state), canon);
+    return make_key(canon, state.board.size(), player);
+}
+
+size_t key_bytes(const size_t cells) {
+    // Two bits for each cell and for the player to move, rounded up
+    return (2 * (cells + 1) + 7) / 8;
+}
+
+void write_key(const Key& key, const size_t cells, uint8_t* bytes) {
+    for (size_t i = 0; i < key_bytes(cells); ++i) {
+        bytes[i] = static_cast<uint8_t>(key.words.at(i / 8) >> (8 * (i % 8)));
+    }
+}
+
+Key read_key(const uint8_t* bytes, const size_t cells) {
+
+    Key key{};
+    for (size_t i = 0; i < key_bytes(cells); ++i) {
+        key.words.at(i / 8) |= static_cast<uint64_t>(bytes[i]) << (8 * (i % 8));
+    }
+
+    return key;
+}
+
+uint64_t fingerprint(const YGame& game) {
+
+    const auto& graph = game.graph();
+
+    uint64_t h = mix(graph.size());
+    for (Cell cell = 0; cell < graph.size(); ++cell) {
+        h = mix(h ^ static_cast<uint64_t>(game.cell_edge(cell)));
+        for (const auto nhbr : graph.at(cell)) {
+            h = mix(h ^ (uint64_t{nhbr} << 8));
+        }
+    }
+
+    return h;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "symmetry.hpp"
+#include "ygame.hpp"
+
+// A position packed into two bits per slot: slot 0 holds the player to move,
+// and slot cell + 1 holds the player occupying that cell. Since cells fit in
+// a uint8_t there are at most 256 slots, so 512 bits always suffice.
+struct Key {
+    std::array<uint64_t, 8> words;
+
+    explicit Key() : words{} {}
+
+    Player at(const uint32_t slot) const {
+        return static_cast<Player>((words.at(slot / 32) >> (2 * (slot % 32))) & 0x3);
+    }
+
+    void set(const uint32_t slot, const Player player) {
+        auto& word = words.at(slot / 32);
+        const auto shift = 2 * (slot % 32);
+        word = (word & ~(uint64_t{0x3} << shift)) | (static_cast<uint64_t>(player) << shift);
+    }
+
+    bool operator==(const Key& other) const {
+        return words == other.words;
+    }
+
+    bool operator!=(const Key& other) const {
+        return words != other.words;
+    }
+
+    bool operator<(const Key& other) const {
+        return words < other.words;
+    }
+};
+
+uint64_t hash_key(const Key& key, const uint64_t seed = 0);
+
+struct KeyHash {
+    size_t operator()(const Key& key) const {
+        return static_cast<size_t>(hash_key(key));
+    }
+};
+
+Board players(const State& state);
+
+// The moves grouped into classes leading to symmetric positions, ordered by
+// canonical position, with each class in cell order
+std::vector<std::vector<Cell>> move_orbits(const State& state, const YGame& game, const Player player);
+
+// One move from each class of moves leading to symmetric positions, ordered by canonical position
+std::vector<Cell> unique_moves(const State& state, const YGame& game, const Player player);
+
+Key make_key(const Board& board, const size_t cells, const Player player);
+Key position_key(const State& state, const Player player);
+Key canonical_key(const State& state, const YGame& game, const Player player);
+
+// Serialization of keys, using only as many bytes as the board needs
+size_t key_bytes(const size_t cells);
+void write_key(const Key& key, const size_t cells, uint8_t* bytes);
+Key read_key(const uint8_t* bytes, const size_t cells);
+
+// A hash of the board graph and edges, so files written for one board are not read for another
+uint64_t fingerprint(const YGame& game);
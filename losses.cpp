@@ -0,0 +1,304 @@
+#include "losses.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "trace.hpp"
+
+// The hashes in a run, of which only the first is stored whole
+static constexpr size_t run_length = 64;
+
+// The number of filter bits set for each hash
+static constexpr uint32_t filter_bits = 6;
+
+// Never zero, which marks an empty pending slot
+static inline uint64_t loss_hash(const Key& key) {
+    return hash_key(key, 0x6a09e667f3bcc909) | 1;
+}
+
+// Confirms a matching hash, from a seed unrelated to the hash's
+static inline uint16_t loss_check(const Key& key) {
+    return static_cast<uint16_t>(hash_key(key, 0xbb67ae8584caa73b) >> 48);
+}
+
+// Filter bit positions come from a remix of the hash, since its low bits choose the block
+static inline uint64_t bit_hash(const uint64_t hash) {
+    return hash * 0x9e3779b97f4a7c15;
+}
+
+static inline size_t floor_power(const size_t n) {
+    size_t power = 1;
+    while (power * 2 <= n) {
+        power *= 2;
+    }
+    return power;
+}
+
+static void put_varint(std::vector<uint8_t>& bytes, uint64_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t get_varint(const std::vector<uint8_t>& bytes, size_t& pos) {
+    uint64_t value = 0;
+    for (uint32_t shift = 0;; shift += 7) {
+        const auto byte = bytes.at(pos++);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+void LossStore::Runs::push(const uint64_t hash, const uint16_t check) {
+    checks.push_back(check);
+    if (count % run_length == 0) {
+        firsts.push_back(hash);
+        offsets.push_back(deltas.size());
+    } else {
+        put_varint(deltas, hash - last);
+    }
+    last = hash;
+    ++count;
+}
+
+template <typename Visit>
+void LossStore::Runs::each(Visit visit) const {
+    uint64_t hash = 0;
+    size_t pos = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hash = (i % run_length == 0) ? firsts.at(i / run_length) : hash + get_varint(deltas, pos);
+        visit(hash, checks.at(i));
+    }
+}
+
+bool LossStore::Runs::contains(const uint64_t hash, const uint16_t check) const {
+
+    const auto next = std::upper_bound(std::begin(firsts), std::end(firsts), hash);
+    if (next == std::begin(firsts)) {
+        return false;
+    }
+
+    // Decode the run in place up to the hash
+    const auto r = static_cast<size_t>(next - std::begin(firsts)) - 1;
+    const auto end = std::min(count, (r + 1) * run_length);
+
+    auto value = firsts.at(r);
+    auto pos = offsets.at(r);
+    for (auto i = r * run_length;;) {
+        if (value >= hash) {
+            return (value == hash) && (checks.at(i) == check);
+        }
+        if (++i == end) {
+            return false;
+        }
+        value += get_varint(deltas, pos);
+    }
+}
+
+// An eighth of the budget each for the filter and the pending hashes, and the
+// rest for the runs, which are built anew beside the old ones on each merge
+LossStore::LossStore(const size_t bytes)
+    : filter_{}, blocks_{floor_power(std::max<size_t>(bytes / 8 / sizeof(Block), 1))}, limit_{~uint64_t{0}},
+      mutex_{}, pending_(floor_power(std::max<size_t>(bytes / 8 / (2 * sizeof(uint64_t)), 2)), 0),
+      pending_checks_(pending_.size(), 0), pending_count_{0}, merging_{}, merge_running_{false}, merge_done_{},
+      runs_{}, runs_budget_{bytes * 3 / 8} {
+
+    filter_.reset(new Block[blocks_]);
+    clear();
+}
+
+void LossStore::mark(const uint64_t hash) {
+    auto& block = filter_[hash & (blocks_ - 1)];
+    const auto bits = bit_hash(hash);
+    for (uint32_t i = 0; i < filter_bits; ++i) {
+        const auto bit = (bits >> (64 - 9 * (i + 1))) & 0x1ff;
+        block.words[bit / 64].fetch_or(uint64_t{1} << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool LossStore::marked(const uint64_t hash) const {
+    const auto& block = filter_[hash & (blocks_ - 1)];
+    const auto bits = bit_hash(hash);
+    for (uint32_t i = 0; i < filter_bits; ++i) {
+        const auto bit = (bits >> (64 - 9 * (i + 1))) & 0x1ff;
+        if (!(block.words[bit / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LossStore::contains(const Key& key) const {
+
+    const auto hash = loss_hash(key);
+    if ((hash > limit_.load(std::memory_order_relaxed)) || !marked(hash)) {
+        return false;
+    }
+
+    const auto check = loss_check(key);
+
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto mask = pending_.size() - 1;
+    for (auto slot = hash & mask; pending_.at(slot) != 0; slot = (slot + 1) & mask) {
+        if (pending_.at(slot) == hash) {
+            return pending_checks_.at(slot) == check;
+        }
+    }
+
+    const auto it = std::lower_bound(std::begin(merging_), std::end(merging_), std::make_pair(hash, uint16_t{0}));
+    if ((it != std::end(merging_)) && (it->first == hash)) {
+        return it->second == check;
+    }
+
+    return runs_.contains(hash, check);
+}
+
+void LossStore::insert(const Key& key) {
+
+    const auto hash = loss_hash(key);
+    if (hash > limit_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex_};
+
+    // While a merge is under way the pending table keeps filling, and past
+    // three quarters new losses are forgotten rather than waiting for it
+    if (merge_running_ && (4 * pending_count_ >= 3 * pending_.size())) {
+        return;
+    }
+
+    const auto mask = pending_.size() - 1;
+    auto slot = hash & mask;
+    for (; pending_.at(slot) != 0; slot = (slot + 1) & mask) {
+        if (pending_.at(slot) == hash) {
+            return;
+        }
+    }
+
+    pending_.at(slot) = hash;
+    pending_checks_.at(slot) = loss_check(key);
+    ++pending_count_;
+    mark(hash);
+
+    // Probes grow long past half full
+    if ((2 * pending_count_ >= pending_.size()) && !merge_running_) {
+        merge(lock);
+    }
+}
+
+void LossStore::merge(std::unique_lock<std::mutex>& lock) {
+
+    const TraceSpan span{"loss merge", "positions", static_cast<int64_t>(runs_.count + pending_count_)};
+
+    // Move the pending hashes aside, where lookups still find them
+    merging_.clear();
+    merging_.reserve(pending_count_);
+    for (size_t slot = 0; slot < pending_.size(); ++slot) {
+        if (pending_.at(slot) != 0) {
+            merging_.emplace_back(pending_.at(slot), pending_checks_.at(slot));
+            pending_.at(slot) = 0;
+        }
+    }
+    pending_count_ = 0;
+
+    std::sort(std::begin(merging_), std::end(merging_));
+
+    merge_running_ = true;
+    auto limit = limit_.load(std::memory_order_relaxed);
+
+    lock.unlock();
+
+    // Merge the old runs with the fresh hashes, skipping any already there
+    // and any that arrived as the limit was lowered
+    Runs merged{};
+    auto next = std::begin(merging_);
+
+    runs_.each([&](const uint64_t hash, const uint16_t check) {
+        for (; (next != std::end(merging_)) && (next->first <= hash); ++next) {
+            if ((next->first < hash) && (next->first <= limit)) {
+                merged.push(next->first, next->second);
+            }
+        }
+        merged.push(hash, check);
+    });
+    for (; next != std::end(merging_); ++next) {
+        if (next->first <= limit) {
+            merged.push(next->first, next->second);
+        }
+    }
+
+    // Keep half as many hashes at a time until they fit
+    const auto dropping = merged.bytes() > runs_budget_;
+    while (merged.bytes() > runs_budget_) {
+        limit >>= 1;
+
+        Runs kept{};
+        merged.each([&](const uint64_t hash, const uint16_t check) {
+            if (hash <= limit) {
+                kept.push(hash, check);
+            }
+        });
+        merged = std::move(kept);
+    }
+
+    // The filter still has the dropped hashes, so start it over. Lookups
+    // meanwhile may miss, which only costs a search.
+    if (dropping) {
+        for (size_t b = 0; b < blocks_; ++b) {
+            for (auto& word : filter_[b].words) {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+        merged.each([this](const uint64_t hash, const uint16_t) {
+            mark(hash);
+        });
+    }
+
+    lock.lock();
+
+    runs_ = std::move(merged);
+    merging_.clear();
+
+    if (dropping) {
+        limit_.store(limit, std::memory_order_relaxed);
+
+        // Hashes that arrived during the merge may have been wiped from the filter
+        for (const auto hash : pending_) {
+            if (hash != 0) {
+                mark(hash);
+            }
+        }
+    }
+
+    merge_running_ = false;
+    merge_done_.notify_all();
+}
+
+void LossStore::clear() {
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    merge_done_.wait(lock, [this]() { return !merge_running_; });
+
+    for (size_t b = 0; b < blocks_; ++b) {
+        for (auto& word : filter_[b].words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::fill(std::begin(pending_), std::end(pending_), 0);
+    std::fill(std::begin(pending_checks_), std::end(pending_checks_), 0);
+    pending_count_ = 0;
+    runs_ = Runs{};
+    limit_.store(~uint64_t{0}, std::memory_order_relaxed);
+}
+
+size_t LossStore::size() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return runs_.count + pending_count_;
+}
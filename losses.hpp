@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "key.hpp"
+
+// A compact set of positions proven lost for the player to move, kept behind
+// the cache so that losses it evicts need not be proven again. Positions are
+// stored as 64-bit hashes in sorted runs, each hash after the first of its
+// run written as a variable-length difference from the one before. Beside
+// each hash is a second, independent 16-bit check of the position. Together
+// they take about seven or eight bytes a position rather than the cache's
+// sixteen. A blocked Bloom filter in front answers most misses without taking
+// the lock. A filter hit is accepted only when both the 63-bit hash and the
+// check match. A position that was never inserted is then reported lost with
+// a chance of about n / 2^79 per probe when n positions are held, which is
+// about 2e-14 at ten billion.
+//
+// The store never grows past its budget. When full it keeps only the hashes
+// below a limit, halving the limit until the rest fit, so it holds an even
+// sample of every loss it was given.
+class LossStore {
+    private:
+    // One cache line of filter bits
+    struct Block {
+        std::atomic<uint64_t> words[8];
+    };
+
+    std::unique_ptr<Block[]> filter_;
+    size_t blocks_;
+
+    // Only hashes at most this are kept
+    std::atomic<uint64_t> limit_;
+
+    // Sorted hashes in runs of a fixed length
+    struct Runs {
+        // The first hash of each run, and where the differences of the rest start
+        std::vector<uint64_t> firsts;
+        std::vector<uint64_t> offsets;
+        std::vector<uint8_t> deltas;
+
+        // The check of every hash, in the same order
+        std::vector<uint16_t> checks;
+
+        size_t count;
+        uint64_t last;
+
+        explicit Runs() : firsts{}, offsets{}, deltas{}, checks{}, count{0}, last{0} {}
+
+        // Add a hash larger than any so far, with its check
+        void push(const uint64_t hash, const uint16_t check);
+
+        // Call visit with every hash in order and its check
+        template <typename Visit>
+        void each(Visit visit) const;
+
+        bool contains(const uint64_t hash, const uint16_t check) const;
+
+        size_t bytes() const {
+            return deltas.size() + 16 * firsts.size() + 2 * checks.size();
+        }
+    };
+
+    // Everything below is guarded by the mutex, except that the thread
+    // merging reads the runs and the hashes being merged without it, since
+    // nothing else changes them until the merge is done
+    mutable std::mutex mutex_;
+
+    // Recent hashes not yet merged into the runs and their checks, in an
+    // open addressing table where zero marks an empty slot
+    std::vector<uint64_t> pending_;
+    std::vector<uint16_t> pending_checks_;
+    size_t pending_count_;
+
+    // The hashes being merged into the runs, sorted, and whether a merge is
+    // under way, with the condition signalled once it is done
+    std::vector<std::pair<uint64_t, uint16_t>> merging_;
+    bool merge_running_;
+    std::condition_variable merge_done_;
+
+    Runs runs_;
+    size_t runs_budget_;
+
+    void mark(const uint64_t hash);
+    bool marked(const uint64_t hash) const;
+
+    // Merge the pending hashes into the runs, dropping hashes until they fit.
+    // Called with the lock held, which is released while the new runs are built.
+    void merge(std::unique_lock<std::mutex>& lock);
+
+    public:
+    // A store taking about bytes of memory in all
+    explicit LossStore(const size_t bytes);
+
+    LossStore(const LossStore&) = delete;
+    LossStore& operator=(const LossStore&) = delete;
+
+    bool contains(const Key& key) const;
+    void insert(const Key& key);
+    void clear();
+
+    // The number of positions held
+    size_t size() const;
+};
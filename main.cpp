@@ -1,123 +1,401 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "book.hpp"
 #include "cell.hpp"
+#include "cli.hpp"
 #include "custom.hpp"
+#include "distribute.hpp"
+#include "engine.hpp"
 #include "geodesic.hpp"
-#include "negamax.hpp"
+#include "proof.hpp"
+#include "solver.hpp"
 #include "state.hpp"
+#include "strategy.hpp"
+#include "trace.hpp"
 #include "util.hpp"
 
-static Cell parse_base(const std::string& base_str) {
+enum class Mode {
+    Solve,
+    Book,
+    Coordinator,
+    Worker,
+    Play,
+    Estimate,
+    Analyze,
+    Batch,
+    Strategy,
+    Lookup,
+};
+
+static Mode parse_mode(const std::string& mode_str) {
+    if (mode_str == "solve") {
+        return Mode::Solve;
+    } else if (mode_str == "book") {
+        return Mode::Book;
+    } else if (mode_str == "coordinator") {
+        return Mode::Coordinator;
+    } else if (mode_str == "worker") {
+        return Mode::Worker;
+    } else if (mode_str == "play") {
+        return Mode::Play;
+    } else if (mode_str == "estimate") {
+        return Mode::Estimate;
+    } else if (mode_str == "analyze") {
+        return Mode::Analyze;
+    } else if (mode_str == "batch") {
+        return Mode::Batch;
+    } else if (mode_str == "strategy") {
+        return Mode::Strategy;
+    } else if (mode_str == "lookup") {
+        return Mode::Lookup;
+    } else {
+        throw std::runtime_error("error: invalid mode " + mode_str);
+    }
+}
 
-    auto base = parse_int<Cell>(base_str);
+struct Options {
+    Mode mode = Mode::Solve;
+    std::string board_str = "";
+    Player player = Player::Black;
+    bool moves = false;
+    Cell depth = 1;
+    std::string book_file = "";
+    std::string proof_file = "";
+    uint32_t threads = std::thread::hardware_concurrency();
+    size_t cache_size = 1 << 22;
+    size_t losses_mb = 0;
+    bool lazy_smp = false;
+    std::string spool = "";
+    Cell split = 1;
+    uint32_t workers = 0;
+    Cell plies = 0;
+    uint32_t time_ms = 1000;
+    uint32_t probes = 100;
+    Cell frontier = 13;
+    std::string trace_file = "";
+    std::string checkpoint_file = "";
+    uint32_t checkpoint_interval = 600;
+    std::string resume_file = "";
+    std::string batch_file = "";
+    std::string strategy_file = "";
+
+    // What a worker process needs to be started with to play the same game
+    std::vector<std::string> worker_args{};
+};
+
+// Print each root move as it is decided, by the number it goes by on the command line
+static Progress move_printer(const YGame& ygame) {
+    return [&ygame](const MoveResult& move) {
+        std::cout << "Move " << static_cast<uint32_t>(ygame.cell_label(move.move)) << ": " << move.outcome
+                  << (move.book ? " (book)" : "") << std::endl;
+    };
+}
 
-    if (base < 2) {
-        throw std::runtime_error("invalid base: " + base_str);
+static void print_wins(const YGame& ygame, const std::vector<Cell>& wins) {
+
+    std::vector<uint32_t> labels{};
+    for (const auto cell : wins) {
+        labels.push_back(ygame.cell_label(cell));
     }
+    std::sort(std::begin(labels), std::end(labels));
 
-    // Cells are represented as uint8_t, so the largest base
-    // we can use right now is 13.
-    if (base > 13) {
-        throw std::runtime_error("base too large: " + base_str);
+    std::cout << "Winning moves: ";
+    for (const auto label : labels) {
+        std::cout << label << ' ';
     }
+    std::cout << std::endl;
+}
 
-    return base;
+static void print_stats(const uint64_t nodes, const std::chrono::steady_clock::time_point start) {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Searched " << nodes << " positions in " << elapsed.count() << "s" << std::endl;
 }
 
-static Player parse_player(const std::string& player_str) {
+// An interactive session on one board: moves are played one at a time, and
+// while waiting for the next command the solver ponders what comes after
+static void analyze(const YGame& ygame, Solver& solver, State state, Player player) {
 
-    if (player_str == "black") {
-        return Player::Black;
-    } else if (player_str == "white") {
-        return Player::White;
-    } else {
-        throw std::runtime_error("invalid player: " + player_str);
+    bool over = false;
+
+    std::cout << "Commands: play <cell>, solve, moves, board, quit" << std::endl;
+
+    std::string line{};
+    while (std::getline(std::cin, line)) {
+
+        const auto words = split(line, ' ');
+        if (words.empty()) {
+            continue;
+        }
+
+        // Whatever comes next, the background solves give way to it
+        solver.stop_pondering();
+
+        const auto& command = words.at(0);
+
+        try {
+            if ((command == "quit") || (command == "exit")) {
+                break;
+            } else if (command == "board") {
+                std::cout << "Board: \"" << board_string(ygame, state) << "\", " << player << " to move" << std::endl;
+            } else if (over) {
+                std::cout << "error: the game is over" << std::endl;
+            } else if ((command == "play") && (words.size() == 2)) {
+                const auto label = parse_int<Cell>(words.at(1));
+                const auto cell = (label < state.board.size()) ? ygame.label_cell(label) : label;
+                if ((cell >= state.board.size()) || (state.board.at(cell).player != Player::None)) {
+                    throw std::runtime_error("error: " + words.at(1) + " is not an empty cell");
+                }
+
+                state.move(ygame, player, cell);
+                if (state.won(cell)) {
+                    std::cout << player << " wins" << std::endl;
+                    over = true;
+                }
+                player = !player;
+            } else if (command == "solve") {
+                const auto result = solver.solve(state, player, move_printer(ygame));
+                std::cout << "Outcome: " << result.outcome << std::endl;
+            } else if (command == "moves") {
+                const auto result = solver.winning_moves(state, player, move_printer(ygame));
+                print_wins(ygame, result.wins);
+            } else {
+                std::cout << "error: unknown command " << line << std::endl;
+            }
+        } catch (const std::runtime_error& err) {
+            std::cout << err.what() << std::endl;
+        }
+
+        if (!over) {
+            solver.ponder(state, player);
+        }
     }
 }
 
-static State parse_board(const YGame& game, const std::string& board_str) {
+static void solve_game(const YGame& ygame, const Options& opts) {
+
+    State state = parse_board(ygame, opts.board_str);
+    const auto player = opts.player;
+
+    if (opts.mode == Mode::Play) {
+        std::cout << "Searching for a move for " << player << std::endl;
+
+        const auto choice = best_move(state, ygame, player, opts.plies, std::chrono::milliseconds{opts.time_ms},
+                                      [&ygame](const Choice& best) {
+            std::cout << "Depth " << static_cast<uint32_t>(best.depth) << ": move "
+                      << static_cast<uint32_t>(ygame.cell_label(best.move)) << " (score " << best.score << ")" << std::endl;
+        });
+
+        std::cout << "Best move: " << static_cast<uint32_t>(ygame.cell_label(choice.move)) << " (score " << choice.score
+                  << ", depth " << static_cast<uint32_t>(choice.depth) << ")" << std::endl;
+        return;
+    }
+
+    if ((opts.mode == Mode::Strategy) || (opts.mode == Mode::Lookup)) {
+        if (opts.strategy_file.empty()) {
+            throw std::runtime_error("error: strategies require --strategy=<path>");
+        }
+
+        if (opts.mode == Mode::Strategy) {
+            if (opts.proof_file.empty()) {
+                throw std::runtime_error("error: --mode=strategy requires --proof=<path> of a finished solve");
+            }
+
+            const auto count = compile_strategy(ygame, opts.proof_file, opts.strategy_file);
+            std::cout << "Strategy: " << count << " positions written to " << opts.strategy_file << std::endl;
+            return;
+        }
 
-    State state{game};
+        const StrategyTable table{ygame, opts.strategy_file};
 
-    std::vector<Player> board{state.board.size(), Player::None};
+        const auto start = std::chrono::steady_clock::now();
+        Cell move = 0;
+        const auto found = table.lookup(state, player, move);
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
 
-    const auto moves = split(board_str, ' ');
+        if (!found) {
+            throw std::runtime_error("error: the position is not in the strategy");
+        }
 
-    for (const auto& move : moves) {
+        std::cout << "Move " << static_cast<uint32_t>(ygame.cell_label(move)) << ": " << Outcome::Win << std::endl
+                  << "Looked up in " << elapsed.count() << "us" << std::endl;
+        return;
+    }
 
-        // The split function skips any empty strings
-        const auto player_chr = move.at(0);
+    if ((opts.mode == Mode::Coordinator) || (opts.mode == Mode::Worker)) {
+        if (opts.spool.empty()) {
+            throw std::runtime_error("error: distributed solving requires --spool=<dir>");
+        }
 
-        Player player;
-        if (player_chr == 'B') {
-            player = Player::Black;
-        } else if (player_chr == 'W') {
-            player = Player::White;
+        if (opts.mode == Mode::Coordinator) {
+            auto worker_args = opts.worker_args;
+            worker_args.push_back("--spool=" + opts.spool);
+            run_coordinator(state, ygame, player, opts.spool, opts.split, worker_args, opts.workers);
         } else {
-            throw std::runtime_error("invalid player: " + std::string{1, player_chr});
+            run_worker(ygame, opts.spool, opts.cache_size);
         }
+        return;
+    }
+
+    Solver solver{ygame, opts.cache_size, opts.threads};
+
+    if (opts.mode == Mode::Estimate) {
+        std::cout << "Estimating the solve for " << player << " with " << opts.probes << " probes" << std::endl;
 
-        const auto cell = parse_int<Cell>(move.substr(1));
+        const auto est = solver.estimate(state, player, opts.probes, opts.frontier);
 
-        if (cell >= state.board.size()) {
-            throw std::runtime_error("invalid position: " + std::to_string(cell));
+        if (est.samples == 0) {
+            throw std::runtime_error("error: no probe could be solved, so there is nothing to extrapolate from");
         }
 
-        if (board.at(cell) == !player) {
-            throw std::runtime_error("error: conflicting players for cell " + std::to_string(cell));
+        std::cout << "Probes solved: " << est.samples << std::endl
+                  << "Nodes: " << est.nodes << " (95% prediction interval " << est.nodes_low << " to "
+                  << est.nodes_high << ")" << std::endl
+                  << "Time on one thread: " << est.seconds << "s (95% prediction interval " << est.seconds_low
+                  << "s to " << est.seconds_high << "s)" << std::endl;
+
+        // The probes are timed on one thread, so more threads can only be bounded
+        if (opts.threads > 1) {
+            std::cout << "Time on " << opts.threads << " threads: at least " << est.seconds / opts.threads
+                      << "s, if the search sped up perfectly (only the one thread time is measured)" << std::endl;
         }
 
-        board.at(cell) = player;
+        if (est.wide) {
+            std::cout << "The interval spans more than a factor of 100, so the estimate is only a rough guess:"
+                      << " try more probes or a larger --frontier" << std::endl;
+        }
+        return;
     }
 
-    for (Cell cell = 0; cell < board.size(); ++cell) {
-        const auto player = board.at(cell);
-        if (player != Player::None) {
-            state.move(game, player, cell);
+    if (opts.mode == Mode::Book) {
+        if (opts.book_file.empty()) {
+            throw std::runtime_error("error: --mode=book requires --book=<path>");
+        }
 
-            if (state.won(cell)) {
-                throw std::runtime_error("error: initial board cannot be won");
+        const auto& path = opts.book_file;
+        const auto written = solver.build_book(state, player, opts.depth, path, [&](const BookProgress& report) {
+            if (report.done == 0) {
+                if (report.resumed) {
+                    std::cout << "Resuming book " << path << " with " << report.loaded << " positions" << std::endl;
+                }
+                std::cout << "Solving " << report.todo << " of " << report.deepest
+                          << " positions at depth " << static_cast<uint32_t>(opts.depth) << std::endl;
+            } else {
+                std::cout << "Solved " << report.done << '/' << report.todo << ": " << report.player << ' '
+                          << report.outcome << std::endl;
             }
+        });
+
+        std::cout << "Wrote " << written << " positions to " << path << std::endl;
+        return;
+    }
+
+    std::unique_ptr<Book> book{};
+    if (!opts.book_file.empty()) {
+        book.reset(new Book{ygame, opts.book_file});
+        std::cout << "Loaded " << book->size() << " book positions" << std::endl;
+        solver.set_book(book.get());
+    }
+
+    std::unique_ptr<Proof> proof{};
+    if (!opts.proof_file.empty()) {
+        if (opts.moves) {
+            throw std::runtime_error("error: --proof cannot be combined with --moves");
         }
+        proof.reset(new Proof{opts.proof_file, ygame, state, player});
     }
 
-    return state;
-}
+    solver.set_lazy_smp(opts.lazy_smp);
+    solver.set_loss_store(opts.losses_mb << 20);
 
-enum class Game {
-    Geodesic,
-    Custom,
-};
+    if (opts.mode == Mode::Batch) {
+        if (opts.batch_file.empty()) {
+            throw std::runtime_error("error: --mode=batch requires --batch-file=<path>");
+        }
 
-static Game parse_game(const std::string& game_str) {
-    if (game_str == "geodesic") {
-        return Game::Geodesic;
-    } else if (game_str == "custom") {
-        return Game::Custom;
-    } else {
-        throw std::runtime_error("error: invalid game type " + game_str);
+        // One position per line: the player to move, then the board
+        std::vector<std::string> lines{};
+        std::vector<BatchPosition> positions{};
+        for (const auto& line : split(read_file(opts.batch_file), '\n')) {
+            const auto trimmed = trim_copy(line);
+            if (trimmed.empty()) {
+                continue;
+            }
+
+            const auto space = trimmed.find(' ');
+            const auto batch_player = parse_player(trimmed.substr(0, space));
+            const auto board = (space == std::string::npos) ? "" : trimmed.substr(space + 1);
+
+            lines.push_back(trimmed);
+            positions.emplace_back(parse_board(ygame, board), batch_player);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto outcomes = solver.solve_batch(positions);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::cout << lines.at(i) << ": " << outcomes.at(i) << std::endl;
+        }
+        std::cout << "Solved " << positions.size() << " positions in " << elapsed.count() << "s" << std::endl;
+        return;
     }
-}
 
-static void solve_game(const YGame& ygame, const std::string& board_str, const Player player, const bool moves) {
+    if (opts.mode == Mode::Analyze) {
+        analyze(ygame, solver, state, player);
+        return;
+    }
+
+    if (!opts.checkpoint_file.empty() || !opts.resume_file.empty()) {
+        if (opts.moves || proof) {
+            throw std::runtime_error("error: only a plain solve can be checkpointed");
+        }
+
+        // A resumed solve keeps saving to the checkpoint it came from
+        const auto path = opts.checkpoint_file.empty() ? opts.resume_file : opts.checkpoint_file;
+        solver.set_checkpoint(path, std::chrono::seconds{opts.checkpoint_interval}, [](const std::runtime_error& err) {
+            std::cout << err.what() << std::endl;
+        });
 
-    State state = parse_board(ygame, board_str);
+        if (!opts.resume_file.empty()) {
+            solver.resume(opts.resume_file, state, player);
+            std::cout << "Resumed from " << opts.resume_file << std::endl;
+        }
+    }
 
     std::cout << "Running alpha-beta for " << player << std::endl;
 
-    if (moves) {
-        const auto wins = winning_moves(state, ygame, player);
+    const auto start = std::chrono::steady_clock::now();
 
-        std::cout << "Winning moves: ";
-        for (const auto cell : wins) {
-            std::cout << static_cast<uint32_t>(cell) << ' ';
-        }
-        std::cout << std::endl;
+    if (opts.moves) {
+        const auto result = solver.winning_moves(state, player, move_printer(ygame));
+        print_wins(ygame, result.wins);
+        print_stats(result.nodes, start);
     } else {
-        const auto outcome = winning_outcome(state, ygame, player);
+        const auto result = solver.solve(state, player, move_printer(ygame), proof.get());
+
+        if (result.book) {
+            std::cout << "Book: " << result.outcome << std::endl;
+        }
+
+        std::cout << "Outcome: " << result.outcome << std::endl;
+        print_stats(result.nodes, start);
+
+        if (proof) {
+            const auto winner = (result.outcome == Outcome::Win) ? player : !player;
+            const auto& stream = (*proof)[winner];
+            const auto nodes = stream.nodes();
+            const auto size = stream.size();
 
-        std::cout << "Outcome: " << outcome << std::endl;
+            proof->finish(winner);
+
+            std::cout << "Proof: " << nodes << " nodes, " << size << " bytes written to " << opts.proof_file << std::endl;
+        }
     }
 }
 
@@ -126,28 +404,78 @@ int main(const int argc, const char* argv[]) {
     try {
         // Defaults for each argument
         Cell base = 3;
-        Player player = Player::Black;
-        std::string board_str = "";
-        bool moves = false;
+        Options opts{};
         Game game = Game::Geodesic;
         std::string board_file = "sample-board.txt";
+        bool renumber = true;
+
+        opts.worker_args = {argv[0], "--mode=worker"};
 
         for (int i = 1; i < argc; ++i) {
 
             const std::string arg{argv[i]};
 
+            if ((arg.rfind("--game=", 0) == 0) || (arg.rfind("--base=", 0) == 0) ||
+                (arg.rfind("--board-file=", 0) == 0) || (arg.rfind("--cache=", 0) == 0) || (arg == "--no-renumber")) {
+                opts.worker_args.push_back(arg);
+            }
+
             if (arg.rfind("--game=", 0) == 0) {
                 game = parse_game(arg.substr(7));
             } else if (arg.rfind("--base=", 0) == 0) {
                 base = parse_base(arg.substr(7));
             } else if (arg.rfind("--player=", 0) == 0) {
-                player = parse_player(arg.substr(9));
+                opts.player = parse_player(arg.substr(9));
             } else if (arg.rfind("--board=", 0) == 0) {
-                board_str = arg.substr(8);
+                opts.board_str = arg.substr(8);
             } else if (arg.rfind("--board-file=", 0) == 0) {
                 board_file = arg.substr(13);
+            } else if (arg == "--no-renumber") {
+                renumber = false;
             } else if (arg == "--moves") {
-                moves = true;
+                opts.moves = true;
+            } else if (arg.rfind("--mode=", 0) == 0) {
+                opts.mode = parse_mode(arg.substr(7));
+            } else if (arg.rfind("--depth=", 0) == 0) {
+                opts.depth = parse_int<Cell>(arg.substr(8));
+            } else if (arg.rfind("--book=", 0) == 0) {
+                opts.book_file = arg.substr(7);
+            } else if (arg.rfind("--proof=", 0) == 0) {
+                opts.proof_file = arg.substr(8);
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                opts.threads = parse_int<uint32_t>(arg.substr(10));
+            } else if (arg.rfind("--cache=", 0) == 0) {
+                opts.cache_size = parse_int<size_t>(arg.substr(8));
+            } else if (arg.rfind("--losses=", 0) == 0) {
+                opts.losses_mb = parse_int<size_t>(arg.substr(9));
+            } else if (arg == "--lazy-smp") {
+                opts.lazy_smp = true;
+            } else if (arg.rfind("--spool=", 0) == 0) {
+                opts.spool = arg.substr(8);
+            } else if (arg.rfind("--split=", 0) == 0) {
+                opts.split = parse_int<Cell>(arg.substr(8));
+            } else if (arg.rfind("--workers=", 0) == 0) {
+                opts.workers = parse_int<uint32_t>(arg.substr(10));
+            } else if (arg.rfind("--plies=", 0) == 0) {
+                opts.plies = parse_int<Cell>(arg.substr(8));
+            } else if (arg.rfind("--time=", 0) == 0) {
+                opts.time_ms = parse_int<uint32_t>(arg.substr(7));
+            } else if (arg.rfind("--probes=", 0) == 0) {
+                opts.probes = parse_int<uint32_t>(arg.substr(9));
+            } else if (arg.rfind("--frontier=", 0) == 0) {
+                opts.frontier = parse_int<Cell>(arg.substr(11));
+            } else if (arg.rfind("--trace=", 0) == 0) {
+                opts.trace_file = arg.substr(8);
+            } else if (arg.rfind("--checkpoint=", 0) == 0) {
+                opts.checkpoint_file = arg.substr(13);
+            } else if (arg.rfind("--checkpoint-interval=", 0) == 0) {
+                opts.checkpoint_interval = parse_int<uint32_t>(arg.substr(22));
+            } else if (arg.rfind("--resume=", 0) == 0) {
+                opts.resume_file = arg.substr(9);
+            } else if (arg.rfind("--batch-file=", 0) == 0) {
+                opts.batch_file = arg.substr(13);
+            } else if (arg.rfind("--strategy=", 0) == 0) {
+                opts.strategy_file = arg.substr(11);
             } else if (arg == "-h" || arg == "--help") {
                 std::cout << "Usage: " << argv[0] << " [options]" << std::endl
                           << "--game={geodesic,custom}  The type of Y game to play (default: geodesic)" << std::endl
@@ -155,20 +483,67 @@ int main(const int argc, const char* argv[]) {
                           << "--player={black,white}    The player to go first (default: black)" << std::endl
                           << "--moves                   Show all winning moves (default: show only a single winning move, if any)" << std::endl
                           << "--base=N                  The size of the base of the board (geodesic Y only, default: 3)" << std::endl
-                          << "--board-file=<path>       Path to the board file (custom Y only, default: sample-board.txt)" << std::endl;
+                          << "--board-file=<path>       Path to the board file (custom Y only, default: sample-board.txt)" << std::endl
+                          << "--no-renumber             Keep the board file's cell numbers inside the solver (custom Y only)" << std::endl
+                          << "--mode=MODE               One of (default: solve):" << std::endl
+                          << "                            solve: solve the board" << std::endl
+                          << "                            book: build an opening book below the board" << std::endl
+                          << "                            coordinator: split the board into jobs for worker processes" << std::endl
+                          << "                            worker: solve jobs from a coordinator" << std::endl
+                          << "                            play: pick a move heuristically within a time budget" << std::endl
+                          << "                            estimate: predict the nodes and time a solve would take" << std::endl
+                          << "                            analyze: play and solve interactively, pondering in between" << std::endl
+                          << "                            batch: solve many positions of the board at once" << std::endl
+                          << "                            strategy: compile the proof of a win into a strategy table" << std::endl
+                          << "                            lookup: answer the board from a strategy table" << std::endl
+                          << "--depth=K                 The number of moves covered by the book (default: 1)" << std::endl
+                          << "--book=<path>             The book file to build, resume or consult (default: none)" << std::endl
+                          << "--proof=<path>            Write the proof tree of the outcome to a file (disables the cache)" << std::endl
+                          << "                          or the proof to compile (strategy only)" << std::endl
+                          << "--threads=N               The number of solver threads (default: all cores)" << std::endl
+                          << "--lazy-smp                Search with helper threads that share results through the cache" << std::endl
+                          << "--cache=N                 The number of positions kept in the cache (default: 4194304)" << std::endl
+                          << "--losses=MB               Keep the losses the cache drops in a compact store of this size (default: 0, none)" << std::endl
+                          << "--spool=<dir>             The directory shared by the coordinator and workers" << std::endl
+                          << "--split=D                 The depth of the jobs below the board (coordinator only, default: 1)" << std::endl
+                          << "--workers=N               The number of local workers to start (coordinator only, default: 0)" << std::endl
+                          << "--plies=N                 The deepest search in moves (play only, default: no limit)" << std::endl
+                          << "--time=MS                 The time budget in milliseconds (play only, default: 1000)" << std::endl
+                          << "--probes=N                The number of random probes (estimate only, default: 100)" << std::endl
+                          << "--frontier=E              The largest probe solved, in empty cells (estimate only, at least 10, default: 13)" << std::endl
+                          << "--trace=<path>            Write a Chrome trace of what each thread did to a file" << std::endl
+                          << "--checkpoint=<path>       Save the progress of the solve to a file periodically" << std::endl
+                          << "--checkpoint-interval=S   The seconds between checkpoints (default: 600)" << std::endl
+                          << "--resume=<path>           Continue a solve from its checkpoint, and keep saving to it" << std::endl
+                          << "--batch-file=<path>       The positions to solve, one per line as a player and a board (batch only)" << std::endl
+                          << "--strategy=<path>         The strategy table to compile or look up (strategy and lookup only)" << std::endl;
                 return EXIT_SUCCESS;
             } else {
                 throw std::runtime_error("unknown argument: " + arg);
             }
         }
 
+        if (!opts.trace_file.empty()) {
+            start_trace();
+            trace_thread("main");
+        }
+
         // TODO rethink how to do this...
         if (game == Game::Geodesic) {
             GeodesicY ygame{base};
-            solve_game(ygame, board_str, player, moves);
+            solve_game(ygame, opts);
         } else if (game == Game::Custom) {
-            CustomY ygame{board_file};
-            solve_game(ygame, board_str, player, moves);
+            CustomY ygame{board_file, renumber};
+            if (ygame.renumbered()) {
+                std::cout << "Renumbered cells: bandwidth " << static_cast<uint32_t>(ygame.file_bandwidth())
+                          << " -> " << static_cast<uint32_t>(ygame.bandwidth()) << std::endl;
+            }
+            solve_game(ygame, opts);
+        }
+
+        if (!opts.trace_file.empty()) {
+            write_trace(opts.trace_file);
+            std::cout << "Trace written to " << opts.trace_file << std::endl;
         }
 
     } catch (const std::runtime_error& err) {
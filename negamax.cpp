@@ -1,215 +1,591 @@
 #include "negamax.hpp"
 
+#include <algorithm>
+#include <array>
 #include <future>
-#include <iostream>
 #include <map>
+#include <random>
 #include <utility>
 
-static std::vector<Player> min_perm(const std::vector<Player>& board, const YGame& game) {
+#include "endgame.hpp"
+#include "trace.hpp"
 
-    auto min = board;
+// Positions with this few empty cells are decided by the endgame solver instead of searched
+static constexpr uint32_t endgame_moves = endgame_max_moves;
 
-    std::vector<Player> newboard{board.size()};
+static uint32_t count_moves(const State& state) {
+    uint32_t moves = 0;
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        if (state.board.at(cell).player == Player::None) {
+            ++moves;
+        }
+    }
+    return moves;
+}
 
-    for (const auto& perm : game.perms()) {
+// Proof recording: a node is an OR node in the proof for the player to move,
+// which keeps only the winning move, and an AND node in the proof for the
+// opponent, which lists every move tried.
+static void proof_node(Search& search, const Player player, const uint32_t moves) {
+    if (search.proof != nullptr) {
+        (*search.proof)[!player].and_node(moves);
+    }
+}
 
-        for (Cell cell = 0; cell < board.size(); ++cell) {
-            newboard.at(perm.at(cell)) = board.at(cell);
-        }
+static ProofStream::Mark proof_move(Search& search, const Player player, const Cell cell) {
 
-        if (newboard < min) {
-            min = newboard;
-        }
+    if (search.proof == nullptr) {
+        return ProofStream::Mark{};
     }
 
-    return min;
+    auto& proof = (*search.proof)[player];
+    const auto mark = proof.mark();
+
+    proof.or_node(cell);
+    (*search.proof)[!player].reply(cell);
+
+    return mark;
 }
 
-static std::map<std::vector<Player>, Cell> unique_moves(const State& state, const YGame& game, const Player player) {
+static void proof_won(Search& search, const Player player) {
+    if (search.proof != nullptr) {
+        // The move ended the game, so there are no replies
+        (*search.proof)[player].and_node(0);
+    }
+}
 
-    // Copy the current players into a vector
-    std::vector<Player> board{state.board.size()};
-    for (Cell cell = 0; cell < state.board.size(); ++cell) {
-        board.at(cell) = state.board.at(cell).player;
+static void proof_rewind(Search& search, const Player player, const ProofStream::Mark& mark) {
+    if (search.proof != nullptr) {
+        (*search.proof)[player].rewind(mark);
     }
+}
+
+// Decide a position with at most two empty cells from the filled boards alone.
+// Whichever cell the player takes, the opponent fills the other, and since
+// connections are never broken and there are no draws, the player wins exactly
+// when one of their moves wins immediately.
+static Outcome last_moves(const State& state, Search& search, const Player player) {
 
-    std::map<std::vector<Player>, Cell> moves{};
+    State child = state;
     for (Cell cell = 0; cell < state.board.size(); ++cell) {
         if (state.board.at(cell).player == Player::None) {
-            board.at(cell) = player;
+            child = state;
+            child.move(search.game, player, cell);
 
-            auto min = min_perm(board, game);
-            moves[min] = cell;
+            if (child.won(cell)) {
+                return Outcome::Win;
+            }
+        }
+    }
+
+    return Outcome::Lose;
+}
 
-            board.at(cell) = Player::None;
+static Outcome negamax(const State& state, Search& search, const Player player);
+static Outcome negamax_prune(const State& state, Search& search, const Player player);
+
+// The empty cells where each player would join all three edges at once: the
+// number of them, and one of them
+struct Threats {
+    std::array<uint32_t, 2> count;
+    std::array<Cell, 2> cell;
+};
+
+static Threats find_threats(const State& state, const YGame& game) {
+
+    Threats threats{};
+
+    // Path compression changes the state, so find the groups in a copy
+    State groups = state;
+
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        if (state.board.at(cell).player != Player::None) {
+            continue;
+        }
+
+        std::array<uint8_t, 2> edges{};
+        edges.fill(static_cast<uint8_t>(state.board.at(cell).edge));
+
+        for (const auto nhbr : game.graph().at(cell)) {
+            const auto owner = state.board.at(nhbr).player;
+            if (owner != Player::None) {
+                edges.at(static_cast<uint8_t>(owner)) |= static_cast<uint8_t>(groups.board.at(groups.root(nhbr)).edge);
+            }
+        }
+
+        for (size_t p = 0; p < 2; ++p) {
+            if (edges.at(p) == static_cast<uint8_t>(Edge::All)) {
+                ++threats.count.at(p);
+                threats.cell.at(p) = cell;
+            }
         }
     }
 
-    return moves;
+    return threats;
+}
+
+// Decide a position where a player already has a virtual connection through
+// edge templates, which wins whoever is to move
+static bool decide_templates(const State& state, const Search& search, const Player player, Outcome& outcome) {
+
+    const auto& templates = search.game.templates();
+
+    if (virtual_win(state, templates, player)) {
+        outcome = Outcome::Win;
+        return true;
+    }
+
+    if (virtual_win(state, templates, !player)) {
+        outcome = Outcome::Lose;
+        return true;
+    }
+
+    return false;
+}
+
+// Decide a position from the immediate threats, where they are enough. A
+// player can never be cut off from the edges by stones alone, since with no
+// draws that would mean the opponent had already connected them, so the
+// earliest a loss shows is the opponent having two winning cells to block.
+static bool decide_threats(const State& state, Search& search, const Player player, const bool prune, Outcome& outcome) {
+
+    const auto threats = find_threats(state, search.game);
+    const auto mine = static_cast<uint8_t>(player);
+    const auto theirs = static_cast<uint8_t>(!player);
+
+    if (threats.count.at(mine) > 0) {
+        outcome = Outcome::Win;
+        return true;
+    }
+
+    if (threats.count.at(theirs) > 1) {
+        outcome = Outcome::Lose;
+        return true;
+    }
+
+    if (threats.count.at(theirs) == 1) {
+        // Every other move loses at once, so only the block is worth searching
+        const auto cell = threats.cell.at(theirs);
+
+        State child = state;
+        child.move(search.game, player, cell);
+
+        outcome = prune ? -negamax_prune(child, search, !player) : -negamax(child, search, !player);
+        return true;
+    }
+
+    return false;
 }
 
-static Outcome negamax(const State& state, const YGame& game, const Player player) {
+static Outcome negamax_moves(const State& state, Search& search, const Player player) {
+
+    if (search.proof != nullptr) {
+        proof_node(search, player, count_moves(state));
+    }
 
     // Undoing moves is tricky because of union-find, so just create a copy
     // of the state for the child.
     State child = state;
-    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+    for (Cell i = 0; i < state.board.size(); ++i) {
+
+        const auto cell = search.order.empty() ? i : search.order[i];
 
         if (state.board.at(cell).player == Player::None) {
 
+            const auto mark = proof_move(search, player, cell);
+
             child = state;
-            child.move(game, player, cell);
+            child.move(search.game, player, cell);
 
             // Normally we check if the game is finished at the start of this function
             // but this is more efficient since we can check immediately if the game is over
             if (child.won(cell)) {
+                proof_won(search, player);
                 return Outcome::Win;
             }
 
-            const auto outcome = negamax(child, game, !player);
+            const auto outcome = negamax(child, search, !player);
 
             // If this is a losing position for the other player, then we won.
             if (outcome == Outcome::Lose) {
                 return Outcome::Win;
             }
+
+            proof_rewind(search, player, mark);
         }
     }
 
     return Outcome::Lose;
 }
 
-static uint32_t count_moves(const State& state) {
-    uint32_t moves = 0;
-    for (Cell cell = 0; cell < state.board.size(); ++cell) {
-        if (state.board.at(cell).player == Player::None) {
-            ++moves;
-        }
+// Count the node and give up if the search has been stopped
+static inline void enter_node(Search& search) {
+
+    // Threads sharing a search may lose the odd count, which is cheaper than a locked add
+    search.nodes.store(search.nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if ((search.stop != nullptr) && search.stop->load(std::memory_order_relaxed)) {
+        throw Stopped{};
     }
-    return moves;
 }
 
-static Outcome negamax_prune(const State& state, const YGame& game, const Player player) {
+// Look in the cache, then among the losses it may have dropped, putting any
+// loss found there back in the cache
+static bool lookup(Search& search, const Key& key, const uint32_t tot_moves, Outcome& outcome) {
+
+    if (search.cache.lookup(key, outcome)) {
+        return true;
+    }
+
+    if ((search.losses != nullptr) && search.losses->contains(key)) {
+        outcome = Outcome::Lose;
+        search.cache.store(key, outcome, tot_moves);
+        return true;
+    }
+
+    return false;
+}
+
+static void store(Search& search, const Key& key, const Outcome outcome, const uint32_t tot_moves) {
+
+    search.cache.store(key, outcome, tot_moves);
+
+    if ((search.losses != nullptr) && (outcome == Outcome::Lose)) {
+        search.losses->insert(key);
+    }
+}
+
+static Outcome negamax(const State& state, Search& search, const Player player) {
+
+    enter_node(search);
 
     const auto tot_moves = count_moves(state);
 
+    // A proof needs every move spelled out, and cannot refer to results found elsewhere in the tree
+    if (search.proof != nullptr) {
+        return negamax_moves(state, search, player);
+    }
+
+    if (tot_moves <= 2) {
+        return last_moves(state, search, player);
+    }
+
+    if (tot_moves <= endgame_moves) {
+        return endgame_outcome(state, search.game, player);
+    }
+
+    const auto key = position_key(state, player);
+
+    Outcome outcome;
+    if (lookup(search, key, tot_moves, outcome)) {
+        return outcome;
+    }
+
+    if (decide_templates(state, search, player, outcome)) {
+        store(search, key, outcome, tot_moves);
+        return outcome;
+    }
+
+    if (decide_threats(state, search, player, false, outcome)) {
+        store(search, key, outcome, tot_moves);
+        return outcome;
+    }
+
+    outcome = negamax_moves(state, search, player);
+    store(search, key, outcome, tot_moves);
+
+    return outcome;
+}
+
+// Put moves in the search's move order, if it has one
+static void order_moves(const Search& search, std::vector<Cell>& moves) {
+
+    if (search.order.empty()) {
+        return;
+    }
+
+    const auto& rank = search.rank;
+    std::sort(std::begin(moves), std::end(moves), [&](const Cell a, const Cell b) {
+        return rank.at(a) < rank.at(b);
+    });
+}
+
+static Outcome negamax_prune_moves(const State& state, Search& search, const Player player, const uint32_t tot_moves) {
+
     // Undoing moves is tricky because of union-find, so just create a copy
     // of the state for the child.
     State child = state;
 
-    const auto moves = unique_moves(state, game, player);
+    auto moves = unique_moves(state, search.game, player);
+    order_moves(search, moves);
 
-    for (const auto& p : moves) {
-        const auto cell = p.second;
+    proof_node(search, player, moves.size());
+
+    for (const auto cell : moves) {
+
+        const auto mark = proof_move(search, player, cell);
 
         child = state;
-        child.move(game, player, cell);
+        child.move(search.game, player, cell);
 
         // Normally we check if the game is finished at the start of this function
         // but this is more efficient since we can check immediately if the game is over
         if (child.won(cell)) {
+            proof_won(search, player);
             return Outcome::Win;
         }
 
         Outcome outcome;
         if (moves.size() == tot_moves) {
             // No isomorphic moves were pruned, so skip checking from now on
-            outcome = negamax(child, game, !player);
+            outcome = negamax(child, search, !player);
         } else {
-            outcome = negamax_prune(child, game, !player);
+            outcome = negamax_prune(child, search, !player);
         }
 
         // If this is a losing position for the other player, then we won.
         if (outcome == Outcome::Lose) {
             return Outcome::Win;
         }
+
+        proof_rewind(search, player, mark);
     }
 
     return Outcome::Lose;
 }
 
-Outcome winning_outcome(const State& state, const YGame& game, const Player player) {
+static Outcome negamax_prune(const State& state, Search& search, const Player player) {
+
+    enter_node(search);
+
+    const auto tot_moves = count_moves(state);
+
+    if (search.proof != nullptr) {
+        return negamax_prune_moves(state, search, player, tot_moves);
+    }
+
+    if (tot_moves <= 2) {
+        return last_moves(state, search, player);
+    }
+
+    if (tot_moves <= endgame_moves) {
+        return endgame_outcome(state, search.game, player);
+    }
+
+    // Symmetric positions share an entry
+    const auto key = canonical_key(state, search.game, player);
+
+    Outcome outcome;
+    if (lookup(search, key, tot_moves, outcome)) {
+        return outcome;
+    }
+
+    if (decide_templates(state, search, player, outcome)) {
+        store(search, key, outcome, tot_moves);
+        return outcome;
+    }
+
+    if (decide_threats(state, search, player, true, outcome)) {
+        store(search, key, outcome, tot_moves);
+        return outcome;
+    }
+
+    outcome = negamax_prune_moves(state, search, player, tot_moves);
+    store(search, key, outcome, tot_moves);
+
+    return outcome;
+}
+
+// Look up the outcome of a position for the player to move in the opening book, if any
+static bool book_outcome(const State& state, Search& search, const Player player, Outcome& outcome) {
+    return (search.book != nullptr) && (search.proof == nullptr) && search.book->lookup(canonical_key(state, search.game, player), outcome);
+}
+
+Outcome solve_outcome(const State& state, Search& search, const Player player) {
+    return negamax_prune(state, search, player);
+}
+
+// Tell the caller how a root move turned out, if they asked
+static void report(const Search& search, const Cell cell, const Outcome outcome, const bool book) {
+    if (search.progress) {
+        search.progress(MoveResult{cell, outcome, book});
+    }
+}
+
+Outcome winning_outcome(const State& state, Search& search, const Player player, Cell& move) {
 
     // The number of empty moves: this determines how deep down the tree we will go
     const auto tot_moves = count_moves(state);
 
+    Outcome book;
+    if (book_outcome(state, search, player, book) && (book == Outcome::Lose)) {
+        // Every move loses, so there is nothing left to analyze
+        return Outcome::Lose;
+    }
+
     // Undoing moves is tricky because of union-find, so just create a copy
     // of the state for the child.
     State child = state;
 
-    const auto moves = unique_moves(state, game, player);
+    auto moves = unique_moves(state, search.game, player);
+    order_moves(search, moves);
 
-    for (const auto& p : moves) {
-        const auto cell = p.second;
+    proof_node(search, player, moves.size());
 
-        std::cout << "Analyzing move " << static_cast<uint32_t>(cell) << ": " << std::flush;
+    for (const auto cell : moves) {
+
+        const TraceSpan span{"root move", "cell", cell};
+
+        const auto mark = proof_move(search, player, cell);
 
         child = state;
-        child.move(game, player, cell);
+        child.move(search.game, player, cell);
 
         Outcome outcome;
+        bool from_book = false;
+
+        const auto known = search.known.find(cell);
 
         // Normally we check if the game is finished at the start of this function
         // but this is more efficient since we can check immediately if the game is over
         if (child.won(cell)) {
+            proof_won(search, player);
             outcome = Outcome::Win;
+        } else if (known != std::end(search.known)) {
+            outcome = known->second;
+        } else if (book_outcome(child, search, !player, book)) {
+            outcome = -book;
+            from_book = true;
         } else {
             if (moves.size() == tot_moves) {
                 // No isomorphic moves were pruned, so skip
-                outcome = -negamax(child, game, !player);
+                outcome = -negamax(child, search, !player);
             } else {
-                outcome = -negamax_prune(child, game, !player);
+                outcome = -negamax_prune(child, search, !player);
             }
         }
 
-        std::cout << outcome << std::endl;
+        report(search, cell, outcome, from_book);
 
         // Short-circuit if a winning move is found
         if (outcome == Outcome::Win) {
+            move = cell;
             return Outcome::Win;
         }
+
+        proof_rewind(search, player, mark);
     }
 
     return Outcome::Lose;
 }
 
-std::vector<Cell> winning_moves(const State& state, const YGame& game, const Player player) {
+std::vector<Cell> winning_moves(const State& state, Search& search, const Player player, ThreadPool& pool) {
+
+    const auto task = [&](const Cell cell) {
 
-    const auto lambda = [&](const Cell cell) {
+        const TraceSpan span{"root move", "cell", cell};
 
         State child = state;
-        child.move(game, player, cell);
+        child.move(search.game, player, cell);
 
         // Normally we check if the game is finished at the start of this function
         // but this is more efficient since we can check immediately if the game is over
         if (child.won(cell)) {
-            return Outcome::Win;
+            return MoveResult{cell, Outcome::Win, false};
         }
 
-        const auto outcome = -negamax(child, game, !player);
+        Outcome book;
+        if (book_outcome(child, search, !player, book)) {
+            return MoveResult{cell, -book, true};
+        }
 
-        return outcome;
+        const auto outcome = -negamax_prune(child, search, !player);
+
+        return MoveResult{cell, outcome, false};
     };
 
-    std::vector<std::pair<Cell, std::future<Outcome>>> futures{};
+    // Symmetric moves have the same outcome, so only one of each orbit is searched
+    const auto orbits = move_orbits(state, search.game, player);
 
-    std::cout << "Analyzing moves ";
-    for (Cell cell = 0; cell < state.board.size(); ++cell) {
-        if (state.board.at(cell).player == Player::None) {
-            std::cout << static_cast<uint32_t>(cell) << ' ';
-            futures.emplace_back(cell, std::async(std::launch::async, lambda, cell));
+    std::vector<std::future<MoveResult>> futures{};
+    for (const auto& orbit : orbits) {
+        futures.push_back(pool.submit(std::bind(task, orbit.front())));
+    }
+
+    std::vector<MoveResult> results{};
+    for (size_t i = 0; i < orbits.size(); ++i) {
+        const auto result = futures.at(i).get();
+        for (const auto cell : orbits.at(i)) {
+            results.push_back(MoveResult{cell, result.outcome, result.book});
         }
     }
-    std::cout << std::endl;
 
+    std::sort(std::begin(results), std::end(results), [](const MoveResult& a, const MoveResult& b) {
+        return a.move < b.move;
+    });
+
+    // Progress is only ever reported from this thread
     std::vector<Cell> wins{};
-    for (auto& fut : futures) {
-        const auto cell = fut.first;
-        const auto outcome = fut.second.get();
-        std::cout << "Move " << static_cast<uint32_t>(cell) << ": " << outcome << std::endl;
-        if (outcome == Outcome::Win) {
-            wins.push_back(cell);
+    for (const auto& result : results) {
+        report(search, result.move, result.outcome, result.book);
+        if (result.outcome == Outcome::Win) {
+            wins.push_back(result.move);
         }
     }
 
     return wins;
 }
+
+Outcome lazy_smp_outcome(const State& state, Search& search, const Player player, ThreadPool& pool, Cell& move) {
+
+    std::atomic<bool> stop{false};
+
+    const auto helper = [&](const uint32_t seed) {
+        const TraceSpan span{"lazy smp helper", "seed", seed};
+
+        Search helper_search{search.game, search.cache};
+        helper_search.losses = search.losses;
+        helper_search.stop = &stop;
+
+        std::vector<Cell> order(state.board.size());
+        for (Cell cell = 0; cell < state.board.size(); ++cell) {
+            order.at(cell) = cell;
+        }
+
+        std::mt19937_64 rng{seed};
+        std::shuffle(std::begin(order), std::end(order), rng);
+        helper_search.set_order(order);
+
+        try {
+            solve_outcome(state, helper_search, player);
+        } catch (const Stopped&) {
+            // The main search finished first
+        }
+    };
+
+    // The calling thread is the last searcher
+    std::vector<std::future<void>> helpers{};
+    for (uint32_t t = 1; t < pool.size(); ++t) {
+        helpers.push_back(pool.submit(std::bind(helper, t)));
+    }
+
+    // The main search keeps the usual order and reports the result, finishing
+    // quickly from the cache once a helper has proven what it needs
+    Outcome outcome;
+    try {
+        outcome = winning_outcome(state, search, player, move);
+    } catch (...) {
+        stop = true;
+        for (auto& helper : helpers) {
+            helper.wait();
+        }
+        throw;
+    }
+
+    stop = true;
+    for (auto& helper : helpers) {
+        helper.get();
+    }
+
+    return outcome;
+}
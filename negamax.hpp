@@ -1,11 +1,85 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <stdexcept>
 #include <vector>
 
+#include "book.hpp"
+#include "cache.hpp"
 #include "cell.hpp"
+#include "losses.hpp"
+#include "pool.hpp"
+#include "proof.hpp"
 #include "ygame.hpp"
 #include "state.hpp"
 
-Outcome winning_outcome(const State& state, const YGame& game, const Player player);
-std::vector<Cell> winning_moves(const State& state, const YGame& game, const Player player);
+// The outcome of one move from the root, and whether it came from the book
+struct MoveResult {
+    Cell move;
+    Outcome outcome;
+    bool book;
+};
 
+// Called on the searching thread as each root move is decided
+using Progress = std::function<void(const MoveResult&)>;
+
+// Everything the search threads through the recursion besides the position itself
+struct Search {
+    const YGame& game;
+    Cache& cache;
+    const Book* book;
+
+    // When set, losses are also kept here, to be found after the cache drops them
+    LossStore* losses;
+
+    // When set, the proof of the result is recorded here and the cache is not used
+    Proof* proof;
+
+    // When set, the search gives up by throwing Stopped as soon as this becomes true
+    const std::atomic<bool>* stop;
+
+    // The order to try moves in, if not from the lowest cell up, and each
+    // cell's place in it. Both start as the board's own, and change through set_order.
+    std::vector<Cell> order;
+    std::vector<Cell> rank;
+
+    // When set, told about each root move as it is decided
+    Progress progress;
+
+    // The number of positions searched so far
+    std::atomic<uint64_t> nodes;
+
+    // Root moves already decided, as when resuming from a checkpoint
+    std::map<Cell, Outcome> known;
+
+    explicit Search(const YGame& game_, Cache& cache_, const Book* book_ = nullptr, Proof* proof_ = nullptr)
+        : game{game_}, cache{cache_}, book{book_}, losses{nullptr}, proof{proof_}, stop{nullptr}, order{}, rank{}, progress{}, nodes{0}, known{} {
+        set_order(game_.move_order());
+    }
+
+    void set_order(const std::vector<Cell>& order_) {
+        order = order_;
+        rank.assign(order.size(), 0);
+        for (Cell i = 0; i < order.size(); ++i) {
+            rank.at(order.at(i)) = i;
+        }
+    }
+};
+
+struct Stopped : public std::runtime_error {
+    explicit Stopped() : std::runtime_error{"search stopped"} {}
+};
+
+Outcome solve_outcome(const State& state, Search& search, const Player player);
+
+// Search the root moves in turn until one wins, returning it through move
+Outcome winning_outcome(const State& state, Search& search, const Player player, Cell& move);
+
+// Decide every root move, one task each on the pool
+std::vector<Cell> winning_moves(const State& state, Search& search, const Player player, ThreadPool& pool);
+
+// Run winning_outcome while the rest of the pool searches the same position
+// with shuffled move orders, sharing what it proves through the cache
+Outcome lazy_smp_outcome(const State& state, Search& search, const Player player, ThreadPool& pool, Cell& move);
@@ -0,0 +1,48 @@
+#include "pool.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "trace.hpp"
+
+ThreadPool::ThreadPool(const uint32_t threads) : threads_{}, tasks_{}, mutex_{}, ready_{}, done_{false} {
+    for (uint32_t t = 0; t < std::max<uint32_t>(threads, 1); ++t) {
+        threads_.emplace_back(&ThreadPool::run, this, t);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_ = true;
+    }
+    ready_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(const uint32_t index) {
+
+    trace_thread("pool " + std::to_string(index));
+
+    while (true) {
+        std::function<void()> task{};
+
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            ready_.wait(lock, [this]() { return done_ || !tasks_.empty(); });
+
+            // Finish everything already submitted before shutting down
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads running tasks in the order they are submitted
+class ThreadPool {
+    private:
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool done_;
+
+    void run(const uint32_t index);
+
+    public:
+    explicit ThreadPool(const uint32_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {
+        return threads_.size();
+    }
+
+    template <typename F>
+    std::future<typename std::result_of<F()>::type> submit(F func) {
+
+        using Result = typename std::result_of<F()>::type;
+
+        // std::function must be copyable, which a packaged_task is not
+        const auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        auto future = task->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            tasks_.emplace_back([task]() { (*task)(); });
+        }
+        ready_.notify_one();
+
+        return future;
+    }
+};
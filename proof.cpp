@@ -0,0 +1,162 @@
+#include "proof.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+
+#include "key.hpp"
+#include "util.hpp"
+
+static const std::string proof_magic = "YPROOF01";
+
+// Flush to the file in large writes; rewinding past a flush seeks back instead
+static constexpr size_t buffer_size = 1 << 20;
+
+ProofStream::ProofStream(const std::string& path, const std::string& header)
+    : path_{path}, file_{path, std::ios::binary | std::ios::trunc}, flushed_{0}, nodes_{0} {
+
+    if (!file_) {
+        throw std::runtime_error("error: unable to write file " + path);
+    }
+
+    buffer_.reserve(buffer_size);
+    buffer_.insert(std::end(buffer_), std::begin(header), std::end(header));
+}
+
+void ProofStream::write(const uint8_t byte) {
+    buffer_.push_back(byte);
+    if (buffer_.size() >= buffer_size) {
+        flush();
+    }
+}
+
+void ProofStream::flush() {
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    flushed_ += buffer_.size();
+    buffer_.clear();
+}
+
+void ProofStream::rewind(const Mark& mark) {
+
+    if (mark.size >= flushed_) {
+        buffer_.resize(mark.size - flushed_);
+    } else {
+        // Anything after the mark is overwritten by later writes, or truncated when closing
+        buffer_.clear();
+        flushed_ = mark.size;
+        file_.seekp(static_cast<std::streamoff>(flushed_));
+    }
+
+    nodes_ = mark.nodes;
+}
+
+void ProofStream::or_node(const Cell move) {
+    ++nodes_;
+    write(move);
+}
+
+void ProofStream::and_node(const uint32_t replies) {
+    ++nodes_;
+    write(static_cast<uint8_t>(replies));
+}
+
+void ProofStream::reply(const Cell cell) {
+    write(cell);
+}
+
+void ProofStream::close() {
+
+    flush();
+    file_.close();
+
+    if (!file_ || (truncate(path_.c_str(), static_cast<off_t>(flushed_)) != 0)) {
+        throw std::runtime_error("error: unable to write file " + path_);
+    }
+}
+
+static std::string proof_header(const YGame& game, const State& state, const Player player, const Player winner) {
+
+    const auto cells = game.graph().size();
+
+    std::ostringstream header{};
+    header << proof_magic;
+    write_uint(header, fingerprint(game), 8);
+    write_uint(header, cells, 4);
+
+    std::vector<uint8_t> bytes(key_bytes(cells));
+    write_key(position_key(state, player), cells, bytes.data());
+    header.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    write_uint(header, static_cast<uint64_t>(winner), 1);
+
+    return header.str();
+}
+
+Proof::Proof(const std::string& path, const YGame& game, const State& state, const Player player) : path_{path} {
+    for (const auto winner : {Player::Black, Player::White}) {
+        std::ostringstream tmp{};
+        tmp << path << '.' << winner << ".tmp";
+        streams_.at(static_cast<size_t>(winner)).reset(new ProofStream{tmp.str(), proof_header(game, state, player, winner)});
+    }
+}
+
+void Proof::finish(const Player winner) {
+    for (const auto player : {Player::Black, Player::White}) {
+        std::ostringstream tmp{};
+        tmp << path_ << '.' << player << ".tmp";
+
+        (*this)[player].close();
+
+        if (player == winner) {
+            if (std::rename(tmp.str().c_str(), path_.c_str()) != 0) {
+                throw std::runtime_error("error: unable to rename " + tmp.str() + " to " + path_);
+            }
+        } else {
+            std::remove(tmp.str().c_str());
+        }
+    }
+}
+
+size_t read_proof_header(const std::string& data, const YGame& game, State& state, Player& player, Player& winner) {
+
+    if (data.compare(0, proof_magic.size(), proof_magic) != 0) {
+        throw std::runtime_error("error: not a proof file");
+    }
+
+    size_t pos = proof_magic.size();
+
+    if (read_uint(data, pos, 8) != fingerprint(game)) {
+        throw std::runtime_error("error: proof was written for a different board");
+    }
+
+    const auto cells = game.graph().size();
+    if (read_uint(data, pos, 4) != cells) {
+        throw std::runtime_error("error: proof was written for a different board");
+    }
+
+    if (pos + key_bytes(cells) > data.size()) {
+        throw std::runtime_error("error: unexpected end of file");
+    }
+
+    const auto key = read_key(reinterpret_cast<const uint8_t*>(data.data() + pos), cells);
+    pos += key_bytes(cells);
+
+    player = key.at(0);
+
+    state = State{game};
+    for (Cell cell = 0; cell < cells; ++cell) {
+        const auto occupant = key.at(cell + 1u);
+        if (occupant != Player::None) {
+            state.move(game, occupant, cell);
+        }
+    }
+
+    winner = static_cast<Player>(read_uint(data, pos, 1));
+
+    if ((player == Player::None) || (winner == Player::None)) {
+        throw std::runtime_error("error: invalid proof header");
+    }
+
+    return pos;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// The proof file format, in pre-order from the root position:
+//
+//   header: "YPROOF01", u64 board fingerprint, u32 number of cells,
+//           the packed root position (see key.hpp), u8 the winning player
+//   OR node (winner to move): u8 winning move, then the AND node below it
+//   AND node (loser to move): u8 number of replies, then for each reply
+//           u8 reply, then the OR node below it
+//
+// An AND node with no replies means the winner's last move completed the
+// game. Replies leading to symmetric positions are only listed once.
+
+// A proof written in depth-first order for a fixed winner. Subtrees that
+// turn out not to be needed are always at the end of the stream, so they
+// are dropped by rewinding, and memory use does not depend on the proof size.
+class ProofStream {
+    private:
+    std::string path_;
+    std::ofstream file_;
+    std::vector<uint8_t> buffer_;
+    uint64_t flushed_;
+    uint64_t nodes_;
+
+    void write(const uint8_t byte);
+    void flush();
+
+    public:
+    struct Mark {
+        uint64_t size;
+        uint64_t nodes;
+    };
+
+    explicit ProofStream(const std::string& path, const std::string& header);
+
+    Mark mark() const {
+        return Mark{flushed_ + buffer_.size(), nodes_};
+    }
+
+    void rewind(const Mark& mark);
+
+    void or_node(const Cell move);
+    void and_node(const uint32_t replies);
+    void reply(const Cell cell);
+
+    uint64_t size() const {
+        return flushed_ + buffer_.size();
+    }
+
+    uint64_t nodes() const {
+        return nodes_;
+    }
+
+    void close();
+};
+
+// Records the proof for both players at once, since which one will win
+// is not known until the search completes.
+class Proof {
+    private:
+    std::string path_;
+    std::array<std::unique_ptr<ProofStream>, 2> streams_;
+
+    public:
+    explicit Proof(const std::string& path, const YGame& game, const State& state, const Player player);
+
+    // The stream proving a win for the given player
+    ProofStream& operator[](const Player winner) {
+        return *streams_.at(static_cast<size_t>(winner));
+    }
+
+    // Keep the winner's proof at the path and discard the other
+    void finish(const Player winner);
+};
+
+// Read the header of a proof file into the root position, returning the offset of the root node
+size_t read_proof_header(const std::string& data, const YGame& game, State& state, Player& player, Player& winner);
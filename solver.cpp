@@ -0,0 +1,234 @@
+#include "solver.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "checkpoint.hpp"
+#include "engine.hpp"
+#include "key.hpp"
+#include "trace.hpp"
+
+Solver::Solver(const YGame& game, const size_t cache_size, const uint32_t threads)
+    : game_{game}, cache_{cache_size}, pool_{threads}, book_{nullptr}, lazy_smp_{false}, losses_{},
+      checkpoint_{}, checkpoint_interval_{0}, checkpoint_failure_{}, resume_mutex_{}, resumed_{}, resumed_key_{},
+      ponder_mutex_{}, ponder_stop_{false}, pondering_{} {}
+
+Solver::~Solver() {
+    stop_pondering();
+}
+
+void Solver::ponder(const State& state, const Player player) {
+
+    std::lock_guard<std::mutex> lock{ponder_mutex_};
+
+    halt_pondering();
+    ponder_stop_ = false;
+
+    // Order the moves by how good they look to player
+    std::vector<std::pair<int32_t, Cell>> moves{};
+    for (const auto cell : unique_moves(state, game_, player)) {
+
+        State child = state;
+        child.move(game_, player, cell);
+
+        // Nothing to solve after a winning move
+        if (!child.won(cell)) {
+            moves.emplace_back(-evaluate(child, game_, !player), cell);
+        }
+    }
+
+    std::stable_sort(std::begin(moves), std::end(moves), [](const std::pair<int32_t, Cell>& a,
+                                                            const std::pair<int32_t, Cell>& b) {
+        return a.first > b.first;
+    });
+
+    for (const auto& move : moves) {
+        const auto cell = move.second;
+
+        pondering_.push_back(pool_.submit([this, state, player, cell]() {
+            if (ponder_stop_) {
+                return;
+            }
+
+            const TraceSpan span{"ponder", "cell", cell};
+
+            State child = state;
+            child.move(game_, player, cell);
+
+            Search search{game_, cache_, book_};
+            search.losses = losses_.get();
+            search.stop = &ponder_stop_;
+
+            try {
+                solve_outcome(child, search, !player);
+            } catch (const Stopped&) {
+                // The next position arrived
+            }
+        }));
+    }
+}
+
+void Solver::stop_pondering() {
+    std::lock_guard<std::mutex> lock{ponder_mutex_};
+    halt_pondering();
+}
+
+void Solver::halt_pondering() {
+
+    ponder_stop_ = true;
+
+    for (auto& task : pondering_) {
+        task.get();
+    }
+    pondering_.clear();
+}
+
+void Solver::resume(const std::string& path, const State& state, const Player player) {
+    stop_pondering();
+    auto moves = read_checkpoint(path, game_, state, player, cache_);
+
+    std::lock_guard<std::mutex> lock{resume_mutex_};
+    resumed_ = std::move(moves);
+    resumed_key_ = position_key(state, player);
+}
+
+SolveResult Solver::solve(const State& state, const Player player, const Progress& progress, Proof* proof) {
+
+    stop_pondering();
+
+    SolveResult result{Outcome::Lose, 0, false, {}, 0};
+
+    Search search{game_, cache_, book_, proof};
+    search.losses = losses_.get();
+
+    {
+        std::lock_guard<std::mutex> lock{resume_mutex_};
+        if (!resumed_.empty() && (resumed_key_ == position_key(state, player))) {
+            search.known = resumed_;
+        }
+    }
+
+    std::unique_ptr<Checkpointer> checkpointer{};
+    if (!checkpoint_.empty()) {
+        if (proof != nullptr) {
+            throw std::runtime_error("error: a proof cannot be checkpointed");
+        }
+        checkpointer.reset(new Checkpointer{checkpoint_, checkpoint_interval_, game_, state, player, search.known, cache_,
+                                            checkpoint_failure_});
+    }
+
+    search.progress = [&](const MoveResult& move) {
+        result.moves.push_back(move);
+        if (checkpointer) {
+            checkpointer->record(move);
+        }
+        if (progress) {
+            progress(move);
+        }
+    };
+
+    // Proofs are only recorded by the main search
+    if (lazy_smp_ && (proof == nullptr)) {
+        result.outcome = lazy_smp_outcome(state, search, player, pool_, result.move);
+    } else {
+        result.outcome = winning_outcome(state, search, player, result.move);
+    }
+
+    // A loss with nothing searched was known from the book
+    result.book = (book_ != nullptr) && (proof == nullptr) && result.moves.empty();
+    result.nodes = search.nodes;
+
+    return result;
+}
+
+MovesResult Solver::winning_moves(const State& state, const Player player, const Progress& progress) {
+
+    stop_pondering();
+
+    MovesResult result{{}, {}, 0};
+
+    Search search{game_, cache_, book_};
+    search.losses = losses_.get();
+    search.progress = [&](const MoveResult& move) {
+        result.moves.push_back(move);
+        if (progress) {
+            progress(move);
+        }
+    };
+
+    result.wins = ::winning_moves(state, search, player, pool_);
+    result.nodes = search.nodes;
+
+    return result;
+}
+
+std::vector<Outcome> Solver::solve_batch(const std::vector<BatchPosition>& positions) {
+
+    stop_pondering();
+
+    std::vector<Outcome> outcomes(positions.size(), Outcome::Lose);
+
+    // Only positions with the same number of empty cells can share lanes
+    std::map<uint32_t, std::vector<size_t>> groups{};
+    std::vector<size_t> large{};
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        uint32_t empty = 0;
+        for (const auto& node : positions.at(i).state.board) {
+            if (node.player == Player::None) {
+                ++empty;
+            }
+        }
+
+        if (empty <= batch_max_moves) {
+            groups[empty].push_back(i);
+        } else {
+            large.push_back(i);
+        }
+    }
+
+    std::vector<std::future<void>> tasks{};
+
+    for (const auto& group : groups) {
+        const auto& indices = group.second;
+
+        for (size_t start = 0; start < indices.size(); start += batch_lanes) {
+            const auto end = std::min<size_t>(start + batch_lanes, indices.size());
+
+            tasks.push_back(pool_.submit([this, &positions, &outcomes, &indices, start, end]() {
+                const TraceSpan span{"batch lanes", "positions", static_cast<int64_t>(end - start)};
+
+                std::vector<const BatchPosition*> lanes{};
+                for (auto i = start; i < end; ++i) {
+                    lanes.push_back(&positions.at(indices.at(i)));
+                }
+
+                const auto results = solve_lanes(game_, lanes);
+                for (auto i = start; i < end; ++i) {
+                    outcomes.at(indices.at(i)) = results.at(i - start);
+                }
+            }));
+        }
+    }
+
+    for (const auto i : large) {
+        tasks.push_back(pool_.submit([this, &positions, &outcomes, i]() {
+            Search search{game_, cache_, book_};
+            search.losses = losses_.get();
+            outcomes.at(i) = solve_outcome(positions.at(i).state, search, positions.at(i).player);
+        }));
+    }
+
+    for (auto& task : tasks) {
+        task.get();
+    }
+
+    return outcomes;
+}
+
+size_t Solver::build_book(const State& state, const Player player, const Cell depth, const std::string& path,
+                          const BookCallback& progress) {
+    stop_pondering();
+    return ::build_book(state, game_, player, depth, path, cache_, pool_.size(), progress);
+}
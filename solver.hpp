@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "batch.hpp"
+#include "book.hpp"
+#include "cache.hpp"
+#include "cell.hpp"
+#include "checkpoint.hpp"
+#include "estimate.hpp"
+#include "losses.hpp"
+#include "negamax.hpp"
+#include "pool.hpp"
+#include "proof.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// The outcome of a position for the player to move
+struct SolveResult {
+    Outcome outcome;
+
+    // A winning move, if the outcome is a win and any move was searched
+    Cell move;
+
+    // Whether the outcome was read straight from the book
+    bool book;
+
+    // The root moves decided on the way, in the order they were searched
+    std::vector<MoveResult> moves;
+
+    // The number of positions searched
+    uint64_t nodes;
+};
+
+// Every winning move of a position for the player to move
+struct MovesResult {
+    std::vector<Cell> wins;
+    std::vector<MoveResult> moves;
+    uint64_t nodes;
+};
+
+// The solver as a library. A Solver owns the cache and worker threads for one
+// board, which the caller keeps alive for as long as the Solver. Any number of
+// threads may call it at once, and they share everything it has proven.
+class Solver {
+    private:
+    const YGame& game_;
+    Cache cache_;
+    ThreadPool pool_;
+    const Book* book_;
+    bool lazy_smp_;
+    std::unique_ptr<LossStore> losses_;
+
+    std::string checkpoint_;
+    std::chrono::seconds checkpoint_interval_;
+    CheckpointFailure checkpoint_failure_;
+
+    // The root moves of a resumed solve and the position they belong to, both
+    // changed only under the mutex since a solve may be reading them
+    std::mutex resume_mutex_;
+    std::map<Cell, Outcome> resumed_;
+    Key resumed_key_;
+
+    // The background solves of likely next positions, and the flag that stops
+    // them, both changed only under the mutex since any caller may stop them
+    std::mutex ponder_mutex_;
+    std::atomic<bool> ponder_stop_;
+    std::vector<std::future<void>> pondering_;
+
+    // Stop the background solves, with the mutex held
+    void halt_pondering();
+
+    public:
+    explicit Solver(const YGame& game, const size_t cache_size, const uint32_t threads);
+    ~Solver();
+
+    Solver(const Solver&) = delete;
+    Solver& operator=(const Solver&) = delete;
+
+    // Consult an opening book for the same board, or none
+    void set_book(const Book* book) {
+        book_ = book;
+    }
+
+    // Search with every worker thread at once rather than one at a time
+    void set_lazy_smp(const bool lazy_smp) {
+        lazy_smp_ = lazy_smp;
+    }
+
+    // Keep proven losses the cache drops in a compact store of about bytes, or none if zero
+    void set_loss_store(const size_t bytes) {
+        losses_.reset((bytes == 0) ? nullptr : new LossStore{bytes});
+    }
+
+    // Save the progress of each solve to path every interval, to be resumed after a
+    // crash, telling failure about any checkpoint that could not be written
+    void set_checkpoint(const std::string& path, const std::chrono::seconds interval,
+                        const CheckpointFailure& failure = CheckpointFailure{}) {
+        checkpoint_ = path;
+        checkpoint_interval_ = interval;
+        checkpoint_failure_ = failure;
+    }
+
+    // Load a checkpoint of a solve of the position, which the next solve of it continues from
+    void resume(const std::string& path, const State& state, const Player player);
+
+    // Solve the positions after each move of player in the background, most
+    // promising first by the heuristic evaluation, leaving what is proven in
+    // the cache for whichever position comes next. Any other call stops it.
+    void ponder(const State& state, const Player player);
+
+    void stop_pondering();
+
+    // Decide the position, recording the proof of the outcome if asked
+    SolveResult solve(const State& state, const Player player,
+                      const Progress& progress = Progress{}, Proof* proof = nullptr);
+
+    MovesResult winning_moves(const State& state, const Player player, const Progress& progress = Progress{});
+
+    // Decide many positions, in lanes of one word wherever they are small
+    // enough and with the usual search otherwise, in the order given
+    std::vector<Outcome> solve_batch(const std::vector<BatchPosition>& positions);
+
+    // Predict how long solve would take on one thread, without solving
+    Estimate estimate(const State& state, const Player player, const uint32_t probes,
+                      const Cell frontier, const uint64_t seed = 0) const {
+        return estimate_tree(state, game_, player, probes, frontier, seed);
+    }
+
+    // Build or resume an opening book below the position, returning the number of positions written
+    size_t build_book(const State& state, const Player player, const Cell depth, const std::string& path,
+                      const BookCallback& progress = BookCallback{});
+
+    void clear_cache() {
+        stop_pondering();
+        cache_.clear();
+        if (losses_) {
+            losses_->clear();
+        }
+    }
+};
@@ -27,4 +27,3 @@ struct State {
     void move(const YGame& game, const Player player, const Cell cell);
     bool won(const Cell cell);
 };
-
@@ -0,0 +1,234 @@
+#include "strategy.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "key.hpp"
+#include "proof.hpp"
+#include "util.hpp"
+
+static const std::string strategy_magic = "YSTRAT01";
+
+static std::string strategy_header(const YGame& game) {
+    std::ostringstream header{};
+    header << strategy_magic;
+    write_uint(header, fingerprint(game), 8);
+    write_uint(header, game.graph().size(), 4);
+    return header.str();
+}
+
+// The header above, then the winner and the number of records
+static size_t header_size(const YGame& game) {
+    return strategy_header(game).size() + 1 + 8;
+}
+
+// The proof being compiled, and the records found so far, each a packed
+// canonical position followed by its winning move
+struct ProofWalk {
+    const YGame& game;
+    const std::string& data;
+    Player winner;
+    std::vector<std::string> records;
+};
+
+static void fail(const size_t pos, const std::string& message) {
+    throw std::runtime_error("error: invalid proof at byte " + std::to_string(pos) + ": " + message);
+}
+
+static uint8_t read_byte(const ProofWalk& walk, size_t& pos) {
+    if (pos >= walk.data.size()) {
+        fail(pos, "unexpected end of file");
+    }
+    return static_cast<uint8_t>(walk.data[pos++]);
+}
+
+static Cell read_move(const ProofWalk& walk, const State& state, size_t& pos) {
+    const auto cell = static_cast<Cell>(read_byte(walk, pos));
+    if ((cell >= state.board.size()) || (state.board.at(cell).player != Player::None)) {
+        fail(pos - 1, "cell " + std::to_string(cell) + " is not an empty cell");
+    }
+    return cell;
+}
+
+// The record for playing move in state, with both carried to the canonical board
+static std::string make_record(const YGame& game, const State& state, const Player player, const Cell move) {
+
+    const auto cells = state.board.size();
+
+    Board canon{};
+    const auto perm = game.symmetry().canonicalize(players(state), canon);
+
+    std::string record(key_bytes(cells) + 1, '\0');
+    write_key(make_key(canon, cells, player), cells, reinterpret_cast<uint8_t*>(&record[0]));
+    record.back() = static_cast<char>((perm < 0) ? move : game.perms().at(static_cast<size_t>(perm)).at(move));
+
+    return record;
+}
+
+static size_t walk_and(ProofWalk& walk, const State& state, size_t pos);
+
+static size_t walk_or(ProofWalk& walk, const State& state, size_t pos) {
+
+    const auto cell = read_move(walk, state, pos);
+    walk.records.push_back(make_record(walk.game, state, walk.winner, cell));
+
+    State child = state;
+    child.move(walk.game, walk.winner, cell);
+
+    return walk_and(walk, child, pos);
+}
+
+static size_t walk_and(ProofWalk& walk, const State& state, size_t pos) {
+
+    const auto count = read_byte(walk, pos);
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto cell = read_move(walk, state, pos);
+
+        State child = state;
+        child.move(walk.game, !walk.winner, cell);
+
+        pos = walk_or(walk, child, pos);
+    }
+
+    return pos;
+}
+
+uint64_t compile_strategy(const YGame& game, const std::string& proof_path, const std::string& path) {
+
+    const auto data = read_file(proof_path);
+
+    State state{game};
+    Player player;
+    Player winner;
+    const auto pos = read_proof_header(data, game, state, player, winner);
+
+    ProofWalk walk{game, data, winner, {}};
+
+    const auto end = (player == winner) ? walk_or(walk, state, pos) : walk_and(walk, state, pos);
+    if (end != data.size()) {
+        throw std::runtime_error("error: proof has trailing data");
+    }
+
+    // The same position may be reached along several lines, and any of its moves wins
+    auto& records = walk.records;
+    std::sort(std::begin(records), std::end(records));
+
+    const auto key_size = key_bytes(game.graph().size());
+    const auto same = [key_size](const std::string& a, const std::string& b) {
+        return a.compare(0, key_size, b, 0, key_size) == 0;
+    };
+    records.erase(std::unique(std::begin(records), std::end(records), same), std::end(records));
+
+    write_file_atomic(path, [&](std::ostream& os) {
+        os << strategy_header(game);
+        write_uint(os, static_cast<uint64_t>(winner), 1);
+        write_uint(os, records.size(), 8);
+        for (const auto& record : records) {
+            os.write(record.data(), static_cast<std::streamsize>(record.size()));
+        }
+    });
+
+    return records.size();
+}
+
+StrategyTable::StrategyTable(const YGame& game, const std::string& path)
+    : game_{game}, cells_{game.graph().size()}, winner_{Player::None}, data_{nullptr}, size_{0}, records_{nullptr}, count_{0} {
+
+    const auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("error: unable to open " + path);
+    }
+
+    struct stat info {};
+    if ((fstat(fd, &info) != 0) || (static_cast<size_t>(info.st_size) < header_size(game))) {
+        close(fd);
+        throw std::runtime_error("error: " + path + " is not a strategy file");
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    const auto map = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping outlives the descriptor
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        throw std::runtime_error("error: unable to map " + path);
+    }
+    data_ = static_cast<const uint8_t*>(map);
+
+    const auto header = strategy_header(game);
+    const std::string fields{reinterpret_cast<const char*>(data_), header_size(game)};
+
+    std::string error{};
+    if (fields.compare(0, strategy_magic.size(), strategy_magic) != 0) {
+        error = "error: " + path + " is not a strategy file";
+    } else if (fields.compare(0, header.size(), header) != 0) {
+        error = "error: strategy " + path + " was compiled for a different board";
+    } else {
+        size_t pos = header.size();
+        winner_ = static_cast<Player>(read_uint(fields, pos, 1));
+        count_ = read_uint(fields, pos, 8);
+        records_ = data_ + pos;
+
+        if ((winner_ == Player::None) || (size_ - pos != count_ * (key_bytes(cells_) + 1))) {
+            error = "error: strategy " + path + " is truncated or corrupt";
+        }
+    }
+
+    if (!error.empty()) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        throw std::runtime_error(error);
+    }
+}
+
+StrategyTable::~StrategyTable() {
+    munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+bool StrategyTable::lookup(const State& state, const Player player, Cell& move) const {
+
+    Board canon{};
+    const auto perm = game_.symmetry().canonicalize(players(state), canon);
+
+    const auto key_size = key_bytes(cells_);
+    const auto record = key_size + 1;
+
+    std::array<uint8_t, 65> key{};
+    write_key(make_key(canon, cells_, player), cells_, key.data());
+
+    // The first record not below the key
+    uint64_t low = 0;
+    uint64_t high = count_;
+    while (low < high) {
+        const auto mid = low + (high - low) / 2;
+        if (std::memcmp(records_ + mid * record, key.data(), key_size) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if ((low == count_) || (std::memcmp(records_ + low * record, key.data(), key_size) != 0)) {
+        return false;
+    }
+
+    const auto canon_move = static_cast<Cell>(records_[low * record + key_size]);
+    if (perm < 0) {
+        move = canon_move;
+        return true;
+    }
+
+    // Carry the move back through the permutation that canonicalized the board
+    const auto& cells = game_.perms().at(static_cast<size_t>(perm));
+    move = static_cast<Cell>(std::find(std::begin(cells), std::end(cells), canon_move) - std::begin(cells));
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "cell.hpp"
+#include "state.hpp"
+#include "ygame.hpp"
+
+// The strategy file format:
+//
+//   header: "YSTRAT01", u64 board fingerprint, u32 number of cells,
+//           u8 the winning player, u64 number of records
+//   records: the packed canonical position (see key.hpp) with the winner to
+//            move, then u8 the winning move on the canonical board
+//
+// The records are sorted by their packed bytes, so the file is searched in
+// place once mapped into memory and nothing is loaded up front.
+
+// Compile the proof file of a win into a strategy file holding the winning
+// move of every position the proof reaches with the winner to move, returning
+// the number of positions written
+uint64_t compile_strategy(const YGame& game, const std::string& proof_path, const std::string& path);
+
+// A strategy file mapped read-only into memory. Positions are canonicalized
+// before the lookup, so the opponent's replies that the proof only covers up
+// to symmetry are answered too, and the move is mapped back onto the board.
+class StrategyTable {
+    private:
+    const YGame& game_;
+    size_t cells_;
+    Player winner_;
+
+    const uint8_t* data_;
+    size_t size_;
+    const uint8_t* records_;
+    uint64_t count_;
+
+    public:
+    explicit StrategyTable(const YGame& game, const std::string& path);
+    ~StrategyTable();
+
+    StrategyTable(const StrategyTable&) = delete;
+    StrategyTable& operator=(const StrategyTable&) = delete;
+
+    uint64_t size() const {
+        return count_;
+    }
+
+    Player winner() const {
+        return winner_;
+    }
+
+    // The winning move for player in state, if the strategy has the position
+    bool lookup(const State& state, const Player player, Cell& move) const;
+};
@@ -0,0 +1,127 @@
+#include "symmetry.hpp"
+
+#include <cstring>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+Symmetry::Symmetry(const std::vector<std::vector<Cell>>& perms, const size_t cells) : cells_{cells} {
+
+    for (const auto& perm : perms) {
+
+        // Permuting sends the player on cell to perm[cell], so invert it to
+        // know where each destination cell reads from
+        std::vector<uint8_t> gather(cells);
+        for (Cell cell = 0; cell < cells; ++cell) {
+            gather.at(perm.at(cell)) = cell;
+        }
+
+        std::vector<Shuffle> shuffles{};
+
+        for (uint32_t block = 0; 32 * block < cells; ++block) {
+            for (uint32_t chunk = 0; 16 * chunk < cells; ++chunk) {
+
+                Shuffle shuffle{};
+                shuffle.block = block;
+                shuffle.chunk = chunk;
+
+                bool used = false;
+                for (uint32_t i = 0; i < 32; ++i) {
+                    const auto dest = 32 * block + i;
+
+                    // The high bit makes the shuffle write a zero
+                    shuffle.control.at(i) = 0x80;
+
+                    if ((dest < cells) && (gather.at(dest) / 16 == chunk)) {
+                        shuffle.control.at(i) = gather.at(dest) % 16;
+                        used = true;
+                    }
+                }
+
+                if (used) {
+                    shuffles.push_back(shuffle);
+                }
+            }
+        }
+
+        gathers_.push_back(gather);
+        shuffles_.push_back(shuffles);
+    }
+}
+
+#ifdef __AVX2__
+
+void Symmetry::permute(const size_t perm, const Board& board, Board& out) const {
+
+    const auto blocks = (cells_ + 31) / 32;
+    for (size_t block = 0; block < blocks; ++block) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data() + 32 * block), _mm256_setzero_si256());
+    }
+
+    for (const auto& shuffle : shuffles_[perm]) {
+        const auto dest = reinterpret_cast<__m256i*>(out.data() + 32 * shuffle.block);
+
+        // Both 128 bit lanes hold the same source chunk, since shuffles cannot cross lanes
+        const auto src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(board.data() + 16 * shuffle.chunk));
+        const auto control = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shuffle.control.data()));
+        const auto bytes = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(src), control);
+
+        _mm256_storeu_si256(dest, _mm256_or_si256(_mm256_loadu_si256(dest), bytes));
+    }
+}
+
+// Negative if a < b, zero if equal, and positive if a > b, comparing the first cells bytes
+static inline int compare(const Board& a, const Board& b, const size_t cells) {
+
+    const auto blocks = (cells + 31) / 32;
+    for (size_t block = 0; block < blocks; ++block) {
+        const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data() + 32 * block));
+        const auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data() + 32 * block));
+
+        const auto equal = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+        if (equal != 0xffffffff) {
+            // The bytes past the last cell are zero in both, so the first difference is a cell
+            const auto i = 32 * block + static_cast<size_t>(__builtin_ctz(~equal));
+            return static_cast<int>(a[i]) - static_cast<int>(b[i]);
+        }
+    }
+
+    return 0;
+}
+
+#else
+
+void Symmetry::permute(const size_t perm, const Board& board, Board& out) const {
+    const auto& gather = gathers_[perm];
+    for (size_t cell = 0; cell < cells_; ++cell) {
+        out[cell] = board[gather[cell]];
+    }
+}
+
+static inline int compare(const Board& a, const Board& b, const size_t cells) {
+    return std::memcmp(a.data(), b.data(), cells);
+}
+
+#endif
+
+int32_t Symmetry::canonicalize(const Board& board, Board& out) const {
+
+    // Only whole 32 byte blocks are ever read or written
+    const auto bytes = 32 * ((cells_ + 31) / 32);
+
+    std::memcpy(out.data(), board.data(), bytes);
+    int32_t best = -1;
+
+    Board image{};
+    for (size_t perm = 0; perm < gathers_.size(); ++perm) {
+        permute(perm, board, image);
+
+        if (compare(image, out, cells_) < 0) {
+            std::memcpy(out.data(), image.data(), bytes);
+            best = static_cast<int32_t>(perm);
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "cell.hpp"
+
+// A board as one byte per cell, holding the Player values. Cells fit in a
+// uint8_t, so 256 bytes always suffice; bytes past the last cell must be zero.
+using Board = std::array<uint8_t, 256>;
+
+// Canonicalizes boards under a set of cell permutations. The permutations are
+// compiled into byte shuffles, so a board is permuted and compared in a few
+// vector instructions when AVX2 is available, and with plain loops otherwise.
+class Symmetry {
+    private:
+    size_t cells_;
+
+    // For each permutation, the source cell of each destination cell
+    std::vector<std::vector<uint8_t>> gathers_;
+
+    // For each permutation, the shuffles building each 32 byte block of the
+    // result, one for every 16 byte chunk of the source that block reads from
+    struct Shuffle {
+        uint32_t block;
+        uint32_t chunk;
+        std::array<uint8_t, 32> control;
+    };
+    std::vector<std::vector<Shuffle>> shuffles_;
+
+    void permute(const size_t perm, const Board& board, Board& out) const;
+
+    public:
+    explicit Symmetry() : cells_{0} {}
+    explicit Symmetry(const std::vector<std::vector<Cell>>& perms, const size_t cells);
+
+    size_t size() const {
+        return gathers_.size();
+    }
+
+    // Write the lexicographically smallest image of board under the
+    // permutations (including the identity) to out, returning the index of
+    // the permutation used, or -1 if it was the identity.
+    int32_t canonicalize(const Board& board, Board& out) const;
+};
@@ -0,0 +1,295 @@
+#include "templates.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+#include "state.hpp"
+
+// The largest region solved, which bounds the table of its positions to 3^12
+static constexpr size_t max_region = 12;
+
+// The most carriers kept for one site, smallest first, which bounds the matching
+static constexpr size_t max_carriers = 4;
+
+static inline uint32_t edge_index(const Edge edge) {
+    switch (edge) {
+        case Edge::Right: return 0;
+        case Edge::Bottom: return 1;
+        case Edge::Left: return 2;
+        default: throw std::runtime_error("error: a template must reach a single edge");
+    }
+}
+
+// The game of joining a stone to an edge within its region, where the cells
+// of the region are numbered by bit and everything outside it is the opponent's
+struct LocalGame {
+    // The region cells next to the stone, next to each region cell, and on the edge
+    uint32_t start;
+    std::vector<uint32_t> adjacent;
+    uint32_t target;
+
+    std::vector<uint32_t> powers;
+
+    // Whether the stone's owner wins, by position and player to move, or -1 if not yet known
+    std::vector<int8_t> memo;
+
+    bool connected(const uint32_t ours) const {
+        auto reach = start & ours;
+        while (true) {
+            auto next = reach;
+            for (auto left = reach; left != 0; left &= left - 1) {
+                next |= adjacent.at(__builtin_ctz(left)) & ours;
+            }
+            if (next == reach) {
+                return (reach & target) != 0;
+            }
+            reach = next;
+        }
+    }
+
+    bool wins(const uint32_t ours, const uint32_t theirs, const bool our_move) {
+
+        if (connected(ours)) {
+            return true;
+        }
+
+        const auto all = static_cast<uint32_t>((uint64_t{1} << adjacent.size()) - 1);
+        const auto empty = all & ~ours & ~theirs;
+
+        if (!connected(ours | empty)) {
+            return false;
+        }
+
+        uint32_t index = 0;
+        for (size_t i = 0; i < adjacent.size(); ++i) {
+            if ((ours >> i) & 1) {
+                index += powers.at(i);
+            } else if ((theirs >> i) & 1) {
+                index += 2 * powers.at(i);
+            }
+        }
+        index = 2 * index + (our_move ? 1 : 0);
+
+        if (memo.at(index) >= 0) {
+            return memo.at(index) != 0;
+        }
+
+        bool result = !our_move;
+        for (auto left = empty; left != 0; left &= left - 1) {
+            const auto bit = uint32_t{1} << __builtin_ctz(left);
+            if (our_move && wins(ours | bit, theirs, false)) {
+                result = true;
+                break;
+            }
+            if (!our_move && !wins(ours, theirs | bit, true)) {
+                result = false;
+                break;
+            }
+        }
+
+        memo.at(index) = result ? 1 : 0;
+        return result;
+    }
+};
+
+// The smallest sets of region cells, as bits, that hold with the opponent moving first
+static std::vector<uint32_t> solve_carriers(LocalGame& game) {
+
+    const auto size = game.adjacent.size();
+
+    uint32_t states = 1;
+    for (size_t i = 0; i < size; ++i) {
+        game.powers.push_back(states);
+        states *= 3;
+    }
+    game.memo.assign(2 * states, -1);
+
+    // Subsets by size, so the first carriers found are the smallest
+    const uint32_t all = (uint32_t{1} << size) - 1;
+    std::vector<uint32_t> subsets{};
+    for (uint32_t subset = 1; subset <= all; ++subset) {
+        subsets.push_back(subset);
+    }
+    std::stable_sort(std::begin(subsets), std::end(subsets), [](const uint32_t a, const uint32_t b) {
+        return __builtin_popcount(a) < __builtin_popcount(b);
+    });
+
+    std::vector<uint32_t> found{};
+    for (const auto subset : subsets) {
+        if (found.size() == max_carriers) {
+            break;
+        }
+
+        const auto covers = std::any_of(std::begin(found), std::end(found), [&](const uint32_t carrier) {
+            return (carrier & subset) == carrier;
+        });
+
+        if (!covers && game.wins(0, all & ~subset, false)) {
+            found.push_back(subset);
+        }
+    }
+
+    return found;
+}
+
+EdgeTemplates::EdgeTemplates(const std::vector<std::vector<Cell>>& graph, const std::vector<Edge>& edges,
+                             const std::vector<TemplateSite>& sites)
+    : carriers_(graph.size()), cells_{} {
+
+    // Most sites are the same shape as others further along the edge, so
+    // each shape is only solved once
+    std::map<std::vector<uint32_t>, std::vector<uint32_t>> solved{};
+
+    for (const auto& site : sites) {
+
+        const auto& region = site.region;
+        if (region.size() > max_region) {
+            throw std::runtime_error("error: template region too large");
+        }
+
+        const auto bit_of = [&](const Cell cell) {
+            const auto it = std::find(std::begin(region), std::end(region), cell);
+            return (it == std::end(region)) ? 0 : uint32_t{1} << (it - std::begin(region));
+        };
+
+        LocalGame game{0, std::vector<uint32_t>(region.size(), 0), 0, {}, {}};
+
+        for (const auto nhbr : graph.at(site.cell)) {
+            game.start |= bit_of(nhbr);
+        }
+
+        for (size_t i = 0; i < region.size(); ++i) {
+            const auto cell = region.at(i);
+            for (const auto nhbr : graph.at(cell)) {
+                game.adjacent.at(i) |= bit_of(nhbr);
+            }
+            if ((static_cast<uint8_t>(edges.at(cell)) & static_cast<uint8_t>(site.edge)) != 0) {
+                game.target |= uint32_t{1} << i;
+            }
+        }
+
+        auto shape = game.adjacent;
+        shape.push_back(game.start);
+        shape.push_back(game.target);
+
+        auto it = solved.find(shape);
+        if (it == std::end(solved)) {
+            it = solved.emplace(shape, solve_carriers(game)).first;
+        }
+
+        auto& carriers = carriers_.at(site.cell).at(edge_index(site.edge));
+        for (const auto subset : it->second) {
+            Bits carrier{};
+            for (size_t i = 0; i < region.size(); ++i) {
+                if ((subset >> i) & 1) {
+                    carrier.set(region.at(i));
+                }
+            }
+            carriers.push_back(carrier);
+        }
+    }
+
+    for (Cell cell = 0; cell < graph.size(); ++cell) {
+        const auto& by_edge = carriers_.at(cell);
+        if (!by_edge.at(0).empty() || !by_edge.at(1).empty() || !by_edge.at(2).empty()) {
+            cells_.push_back(cell);
+        }
+    }
+}
+
+// One way for a group to reach an edge, through the carrier
+struct Reach {
+    Cell root;
+    uint32_t edge;
+    const Bits* carrier;
+};
+
+static bool disjoint(const Bits& a, const Bits& b) {
+    return !(a & b).any();
+}
+
+bool virtual_win(const State& state, const EdgeTemplates& templates, const Player player) {
+
+    if (templates.empty()) {
+        return false;
+    }
+
+    Bits taken{};
+    for (Cell cell = 0; cell < state.board.size(); ++cell) {
+        if (state.board.at(cell).player != Player::None) {
+            taken.set(cell);
+        }
+    }
+
+    // Path compression changes the state, so find the groups in a copy
+    State groups = state;
+
+    std::vector<Reach> reaches{};
+    for (const auto cell : templates.cells()) {
+        if (state.board.at(cell).player != player) {
+            continue;
+        }
+
+        const auto root = groups.root(cell);
+        const auto reached = static_cast<uint8_t>(groups.board.at(root).edge);
+
+        for (uint32_t edge = 0; edge < 3; ++edge) {
+            if ((reached >> edge) & 1) {
+                continue;
+            }
+            for (const auto& carrier : templates.carriers(cell, edge)) {
+                if (disjoint(carrier, taken)) {
+                    reaches.push_back(Reach{root, edge, &carrier});
+                }
+            }
+        }
+    }
+
+    std::sort(std::begin(reaches), std::end(reaches), [](const Reach& a, const Reach& b) {
+        return (a.root < b.root) || ((a.root == b.root) && (a.edge < b.edge));
+    });
+
+    // Each group needs one carrier for each edge it is missing, none overlapping
+    for (size_t begin = 0; begin < reaches.size();) {
+        const auto root = reaches.at(begin).root;
+
+        size_t end = begin;
+        std::array<std::vector<const Bits*>, 3> by_edge{};
+        for (; (end < reaches.size()) && (reaches.at(end).root == root); ++end) {
+            by_edge.at(reaches.at(end).edge).push_back(reaches.at(end).carrier);
+        }
+        begin = end;
+
+        // An edge already reached needs nothing, which one empty carrier stands for
+        const Bits none{};
+        const auto reached = static_cast<uint8_t>(groups.board.at(root).edge);
+
+        bool missing = false;
+        for (uint32_t edge = 0; edge < 3; ++edge) {
+            if ((reached >> edge) & 1) {
+                by_edge.at(edge).push_back(&none);
+            } else if (by_edge.at(edge).empty()) {
+                missing = true;
+            }
+        }
+        if (missing) {
+            continue;
+        }
+
+        for (const auto right : by_edge.at(0)) {
+            for (const auto bottom : by_edge.at(1)) {
+                if (!disjoint(*right, *bottom)) {
+                    continue;
+                }
+                for (const auto left : by_edge.at(2)) {
+                    if (disjoint(*right, *left) && disjoint(*bottom, *left)) {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    return false;
+}
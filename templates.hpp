@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "bits.hpp"
+#include "cell.hpp"
+
+// The board includes this header through YGame
+struct State;
+
+// Where to look for edge templates: a cell, the edge it may reach, and the
+// empty cells around it that a template may use
+struct TemplateSite {
+    Cell cell;
+    Edge edge;
+    std::vector<Cell> region;
+};
+
+// Edge templates: a stone with every cell of a carrier empty is connected to
+// the edge however the opponent plays into the carrier, as long as its owner
+// answers there. The carriers of each site are found once by solving that
+// small game over every subset of the region, keeping the smallest sets that
+// hold with the opponent moving first.
+class EdgeTemplates {
+    private:
+    // The carriers of each cell, by edge
+    std::vector<std::array<std::vector<Bits>, 3>> carriers_;
+
+    // The cells with any carriers, in order
+    std::vector<Cell> cells_;
+
+    public:
+    explicit EdgeTemplates() {}
+    explicit EdgeTemplates(const std::vector<std::vector<Cell>>& graph, const std::vector<Edge>& edges,
+                           const std::vector<TemplateSite>& sites);
+
+    bool empty() const {
+        return cells_.empty();
+    }
+
+    const std::vector<Cell>& cells() const {
+        return cells_;
+    }
+
+    // The carriers joining a stone on cell to an edge, by its index 0, 1, 2 for right, bottom, left
+    const std::vector<Bits>& carriers(const Cell cell, const uint32_t edge) const {
+        return carriers_.at(cell).at(edge);
+    }
+};
+
+// Whether some group of player's joins all three edges, directly or through
+// templates with pairwise disjoint carriers, so that player wins whoever moves
+bool virtual_win(const State& state, const EdgeTemplates& templates, const Player player);
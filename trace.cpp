@@ -0,0 +1,126 @@
+#include "trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> trace_enabled{false};
+
+struct TraceEvent {
+    const char* name;
+    const char* arg_name;
+    int64_t arg;
+    uint64_t start;
+    uint64_t duration;
+};
+
+struct TraceBuffer {
+    uint32_t tid;
+    std::string name;
+    std::vector<TraceEvent> events;
+};
+
+// Buffers outlive their threads, so pool threads can exit before the trace is written
+static std::mutex buffers_mutex{};
+static std::vector<std::unique_ptr<TraceBuffer>> buffers{};
+
+static std::chrono::steady_clock::time_point trace_epoch{};
+
+static thread_local TraceBuffer* local_buffer = nullptr;
+
+static TraceBuffer& thread_buffer() {
+
+    if (local_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock{buffers_mutex};
+
+        std::unique_ptr<TraceBuffer> buffer{new TraceBuffer{static_cast<uint32_t>(buffers.size()), "", {}}};
+        buffer->name = "thread " + std::to_string(buffer->tid);
+
+        local_buffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+
+    return *local_buffer;
+}
+
+static uint64_t trace_now() {
+    const auto elapsed = std::chrono::steady_clock::now() - trace_epoch;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void start_trace() {
+    trace_epoch = std::chrono::steady_clock::now();
+    trace_enabled = true;
+}
+
+void trace_thread(const std::string& name) {
+    if (trace_enabled.load(std::memory_order_relaxed)) {
+        thread_buffer().name = name;
+    }
+}
+
+TraceSpan::TraceSpan(const char* name, const char* arg_name, const int64_t arg)
+    : name_{name}, arg_name_{arg_name}, arg_{arg}, start_{0} {
+    if (trace_enabled.load(std::memory_order_relaxed)) {
+        start_ = trace_now();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (trace_enabled.load(std::memory_order_relaxed)) {
+        const auto end = trace_now();
+        thread_buffer().events.push_back(TraceEvent{name_, arg_name_, arg_, start_, end - start_});
+    }
+}
+
+static std::string json_string(const std::string& str) {
+    std::string out{"\""};
+    for (const auto c : str) {
+        if ((c == '"') || (c == '\\')) {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+void write_trace(const std::string& path) {
+
+    std::ofstream out{path};
+    if (!out) {
+        throw std::runtime_error("error: unable to write trace " + path);
+    }
+
+    std::lock_guard<std::mutex> lock{buffers_mutex};
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    const auto separate = [&]() {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    for (const auto& buffer : buffers) {
+        separate();
+        out << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"name\":\"thread_name\",\"args\":{\"name\":" << json_string(buffer->name) << "}}";
+
+        for (const auto& event : buffer->events) {
+            separate();
+            out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid << ",\"name\":" << json_string(event.name)
+                << ",\"ts\":" << event.start << ",\"dur\":" << event.duration;
+            if (event.arg_name != nullptr) {
+                out << ",\"args\":{" << json_string(event.arg_name) << ':' << event.arg << '}';
+            }
+            out << '}';
+        }
+    }
+
+    out << "\n]}\n";
+}
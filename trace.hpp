@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Optional timeline of what each thread spent its time on, written as Chrome
+// trace-event JSON for chrome://tracing or Perfetto. Every thread records into
+// a buffer of its own, so tracing takes no locks once a thread has started,
+// and when it is off a span costs a single load.
+
+extern std::atomic<bool> trace_enabled;
+
+void start_trace();
+
+// Name the calling thread in the timeline
+void trace_thread(const std::string& name);
+
+// Write everything recorded so far, once the traced threads are idle
+void write_trace(const std::string& path);
+
+// Record the time between construction and destruction as a span, with an
+// optional number shown alongside, like the cell of a root move
+class TraceSpan {
+    private:
+    const char* name_;
+    const char* arg_name_;
+    int64_t arg_;
+    uint64_t start_;
+
+    public:
+    explicit TraceSpan(const char* name, const char* arg_name = nullptr, const int64_t arg = 0);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
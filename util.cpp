@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
-#include <iostream>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "util.hpp"
 
@@ -45,9 +52,8 @@ std::string read_file(const std::string& path) {
 
         return buff.str();
 
-    } catch (const std::runtime_error& err) {
-        std::cout << "error: unable to read file " + path << std::endl;
-        throw err;
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("error: unable to read file " + path);
     }
 }
 
@@ -97,3 +103,105 @@ std::string replace_copy(std::string str, const std::string& search, const std::
 
     return str;
 }
+
+void write_uint(std::ostream& os, const uint64_t value, const size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        os.put(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+uint64_t read_uint(const std::string& data, size_t& pos, const size_t bytes) {
+
+    if (pos + bytes > data.size()) {
+        throw std::runtime_error("error: unexpected end of file");
+    }
+
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data.at(pos + i))) << (8 * i);
+    }
+
+    pos += bytes;
+    return value;
+}
+
+// Write to a temporary file first so readers never see a partially written file
+void write_file_atomic(const std::string& path, const std::string& contents) {
+    write_file_atomic(path, [&](std::ostream& os) {
+        os.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    });
+}
+
+void write_file_atomic(const std::string& path, const std::function<void(std::ostream&)>& write) {
+
+    const auto tmp = path + ".tmp";
+
+    {
+        std::ofstream file{tmp, std::ios::binary | std::ios::trunc};
+        write(file);
+        file.flush();
+
+        if (!file) {
+            throw std::runtime_error("error: unable to write file " + tmp);
+        }
+    }
+
+    // Make sure the contents are on disk before they replace the old file
+    const auto fd = open(tmp.c_str(), O_RDONLY);
+    if ((fd < 0) || (fsync(fd) != 0)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        throw std::runtime_error("error: unable to sync file " + tmp);
+    }
+    close(fd);
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("error: unable to rename " + tmp + " to " + path);
+    }
+}
+
+bool file_exists(const std::string& path) {
+    struct stat info{};
+    return stat(path.c_str(), &info) == 0;
+}
+
+bool touch_file(const std::string& path) {
+    return utimensat(AT_FDCWD, path.c_str(), nullptr, 0) == 0;
+}
+
+uint64_t file_mtime(const std::string& path) {
+    struct stat info{};
+    if (stat(path.c_str(), &info) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000 + static_cast<uint64_t>(info.st_mtim.tv_nsec);
+}
+
+void make_dir(const std::string& path) {
+    if ((mkdir(path.c_str(), 0777) != 0) && (errno != EEXIST)) {
+        throw std::runtime_error("error: unable to create directory " + path);
+    }
+}
+
+// The names of the files in a directory, in sorted order
+std::vector<std::string> list_dir(const std::string& path) {
+
+    const auto dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        throw std::runtime_error("error: unable to read directory " + path);
+    }
+
+    std::vector<std::string> names{};
+    while (const auto entry = readdir(dir)) {
+        const std::string name{entry->d_name};
+        if ((name != ".") && (name != "..")) {
+            names.push_back(name);
+        }
+    }
+
+    closedir(dir);
+
+    std::sort(std::begin(names), std::end(names));
+    return names;
+}
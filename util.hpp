@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <ostream>
 #include <vector>
 #include <stdexcept>
 #include <string>
@@ -65,3 +68,22 @@ std::vector<std::string> split(const std::string& str, const char delim);
 std::string read_file(const std::string& path);
 std::string trim_copy(std::string str);
 std::string replace_copy(std::string str, const std::string& search, const std::string& replace);
+
+// Little-endian binary fields for the book and other solver files
+void write_uint(std::ostream& os, const uint64_t value, const size_t bytes);
+uint64_t read_uint(const std::string& data, size_t& pos, const size_t bytes);
+void write_file_atomic(const std::string& path, const std::string& contents);
+
+// Write a file through a temporary one, synced to disk before it is renamed into place
+void write_file_atomic(const std::string& path, const std::function<void(std::ostream&)>& write);
+bool file_exists(const std::string& path);
+
+// Set the modification time of a file to now, returning whether it exists
+bool touch_file(const std::string& path);
+
+// The modification time of a file in nanoseconds, or zero if it does not exist
+uint64_t file_mtime(const std::string& path);
+
+// Directories used as a spool shared between processes
+void make_dir(const std::string& path);
+std::vector<std::string> list_dir(const std::string& path);
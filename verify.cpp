@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "cell.hpp"
+#include "cli.hpp"
+#include "custom.hpp"
+#include "geodesic.hpp"
+#include "key.hpp"
+#include "proof.hpp"
+#include "state.hpp"
+#include "util.hpp"
+
+// Checks a proof file written by `solve --proof` by replaying it. Every node
+// is checked independently, so subtrees are verified in parallel. One pass
+// over the structure first finds where the subtrees at the top of the tree
+// end, so each byte is read a constant number of times in all.
+
+struct ProofData {
+    const YGame& game;
+    const std::string& data;
+    Player winner;
+};
+
+static void fail(const size_t pos, const std::string& message) {
+    throw std::runtime_error("error: invalid proof at byte " + std::to_string(pos) + ": " + message);
+}
+
+static Cell read_cell(const ProofData& proof, const State& state, size_t& pos) {
+
+    if (pos >= proof.data.size()) {
+        fail(pos, "unexpected end of file");
+    }
+
+    const auto cell = static_cast<Cell>(proof.data[pos]);
+
+    if (cell >= state.board.size()) {
+        fail(pos, "cell " + std::to_string(cell) + " is not on the board");
+    }
+
+    if (state.board.at(cell).player != Player::None) {
+        fail(pos, "cell " + std::to_string(cell) + " is not empty");
+    }
+
+    ++pos;
+    return cell;
+}
+
+static uint32_t read_count(const ProofData& proof, size_t& pos) {
+
+    if (pos >= proof.data.size()) {
+        fail(pos, "unexpected end of file");
+    }
+
+    return static_cast<uint8_t>(proof.data[pos++]);
+}
+
+// Where each node's subtree ends, for the top of the tree only: every level
+// down to the first with enough nodes to share out among the threads, which
+// are the levels checked one at a time before the rest is split up
+struct Offsets {
+    std::vector<std::unordered_map<size_t, size_t>> ends;
+    size_t wanted;
+    size_t limit;
+
+    explicit Offsets(const size_t wanted_) : ends{}, wanted{wanted_}, limit{std::numeric_limits<size_t>::max()} {}
+
+    void record(const size_t depth, const size_t pos, const size_t end) {
+        if (depth > limit) {
+            return;
+        }
+        if (ends.size() <= depth) {
+            ends.resize(depth + 1);
+        }
+
+        ends.at(depth)[pos] = end;
+
+        // Levels below the first with enough nodes are never needed
+        if ((ends.at(depth).size() >= wanted) && (depth < limit)) {
+            limit = depth;
+            ends.resize(depth + 1);
+        }
+    }
+
+    size_t end(const size_t depth, const size_t pos) const {
+        return ends.at(depth).at(pos);
+    }
+};
+
+// Follow the structure of the nodes without checking them, recording where
+// the subtrees near the top end, and returning where this one ends
+static size_t index_and(const ProofData& proof, size_t pos, const size_t depth, Offsets& offsets);
+
+static size_t index_or(const ProofData& proof, const size_t pos, const size_t depth, Offsets& offsets) {
+    if (pos >= proof.data.size()) {
+        fail(pos, "unexpected end of file");
+    }
+
+    const auto end = index_and(proof, pos + 1, depth + 1, offsets);
+    offsets.record(depth, pos, end);
+    return end;
+}
+
+static size_t index_and(const ProofData& proof, size_t pos, const size_t depth, Offsets& offsets) {
+    const auto start = pos;
+    const auto count = read_count(proof, pos);
+    for (uint32_t i = 0; i < count; ++i) {
+        pos = index_or(proof, pos + 1, depth + 1, offsets);
+    }
+    offsets.record(depth, start, pos);
+    return pos;
+}
+
+// A node waiting to be checked: either an OR node with the winner to move,
+// or an AND node with the loser to move, where won says whether the winner's
+// last move ended the game.
+struct Task {
+    bool is_or;
+    bool won;
+    size_t pos;
+    size_t depth;
+    State state;
+
+    explicit Task(const bool is_or_, const bool won_, const size_t pos_, const size_t depth_, const State& state_)
+        : is_or{is_or_}, won{won_}, pos{pos_}, depth{depth_}, state{state_} {}
+};
+
+// Check a single node, handing each node directly below it to visit, which
+// returns where that node's subtree ends, and return where this one ends
+static size_t check_node(const ProofData& proof, const Task& task, const std::function<size_t(const Task&)>& visit) {
+
+    const auto loser = !proof.winner;
+
+    auto pos = task.pos;
+
+    if (task.is_or) {
+        const auto cell = read_cell(proof, task.state, pos);
+
+        State child = task.state;
+        child.move(proof.game, proof.winner, cell);
+
+        return visit(Task{false, child.won(cell), pos, task.depth + 1, child});
+    }
+
+    const auto count = read_count(proof, pos);
+
+    if (count == 0) {
+        if (!task.won) {
+            fail(task.pos, "the game is not over, but no replies are given");
+        }
+        return pos;
+    }
+
+    if (task.won) {
+        fail(task.pos, "the game is already over, but replies are given");
+    }
+
+    // Each listed reply must be legal and not win for the loser, and together
+    // they must cover every reply up to symmetry
+    std::set<Key> covered{};
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto reply_pos = pos;
+        const auto cell = read_cell(proof, task.state, pos);
+
+        State child = task.state;
+        child.move(proof.game, loser, cell);
+
+        if (child.won(cell)) {
+            fail(reply_pos, "reply " + std::to_string(cell) + " wins for the loser");
+        }
+
+        covered.insert(canonical_key(child, proof.game, proof.winner));
+
+        pos = visit(Task{true, false, pos, task.depth + 1, child});
+    }
+
+    for (const auto cell : unique_moves(task.state, proof.game, loser)) {
+        State child = task.state;
+        child.move(proof.game, loser, cell);
+
+        if (covered.count(canonical_key(child, proof.game, proof.winner)) == 0) {
+            fail(task.pos, "reply " + std::to_string(cell) + " is not covered");
+        }
+    }
+
+    return pos;
+}
+
+// Check a whole subtree, counting its nodes, and return where it ends
+static size_t check_tree(const ProofData& proof, const Task& task, uint64_t& nodes) {
+    ++nodes;
+    return check_node(proof, task, [&](const Task& child) {
+        return check_tree(proof, child, nodes);
+    });
+}
+
+static uint64_t verify(const ProofData& proof, const Offsets& offsets, const Task& root, const uint32_t threads) {
+
+    uint64_t nodes = 0;
+
+    // Check the top of the tree level by level until there is enough work to share out
+    std::vector<Task> tasks{root};
+    while (tasks.size() < offsets.wanted) {
+
+        std::vector<Task> next{};
+        for (const auto& task : tasks) {
+            check_node(proof, task, [&](const Task& child) {
+                next.push_back(child);
+                return offsets.end(child.depth, child.pos);
+            });
+        }
+
+        nodes += tasks.size();
+        tasks = next;
+
+        if (tasks.empty()) {
+            return nodes;
+        }
+    }
+
+    std::atomic<size_t> index{0};
+    std::atomic<uint64_t> total{nodes};
+    std::atomic<bool> failed{false};
+    std::mutex mutex{};
+    std::string error{};
+
+    const auto worker = [&]() {
+        try {
+            for (auto i = index++; (i < tasks.size()) && !failed; i = index++) {
+                uint64_t count = 0;
+                check_tree(proof, tasks.at(i), count);
+                total += count;
+            }
+        } catch (const std::runtime_error& err) {
+            std::lock_guard<std::mutex> lock{mutex};
+            failed = true;
+            error = err.what();
+        }
+    };
+
+    std::vector<std::thread> pool{};
+    for (uint32_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    if (failed) {
+        throw std::runtime_error(error);
+    }
+
+    return total;
+}
+
+static void verify_file(const YGame& game, const std::string& path, const uint32_t threads) {
+
+    const auto data = read_file(path);
+
+    State state{game};
+    Player player;
+    Player winner;
+    const auto pos = read_proof_header(data, game, state, player, winner);
+
+    const ProofData proof{game, data, winner};
+
+    const auto workers = std::max<uint32_t>(threads, 1);
+
+    Offsets offsets{64 * size_t{workers}};
+    const auto end = (player == winner) ? index_or(proof, pos, 0, offsets) : index_and(proof, pos, 0, offsets);
+    if (end != data.size()) {
+        throw std::runtime_error("error: proof has trailing data");
+    }
+
+    std::cout << "Verifying that " << winner << " wins with " << player << " to move" << std::endl;
+
+    const Task root{player == winner, false, pos, 0, state};
+    const auto nodes = verify(proof, offsets, root, workers);
+
+    std::cout << "Verified " << nodes << " nodes: " << winner << " wins" << std::endl;
+}
+
+int main(const int argc, const char* argv[]) {
+
+    try {
+        Cell base = 3;
+        Game game = Game::Geodesic;
+        std::string board_file = "sample-board.txt";
+        bool renumber = true;
+        std::string proof_file = "";
+        uint32_t threads = std::thread::hardware_concurrency();
+
+        for (int i = 1; i < argc; ++i) {
+
+            const std::string arg{argv[i]};
+
+            if (arg.rfind("--game=", 0) == 0) {
+                game = parse_game(arg.substr(7));
+            } else if (arg.rfind("--base=", 0) == 0) {
+                base = parse_base(arg.substr(7));
+            } else if (arg.rfind("--board-file=", 0) == 0) {
+                board_file = arg.substr(13);
+            } else if (arg == "--no-renumber") {
+                renumber = false;
+            } else if (arg.rfind("--proof=", 0) == 0) {
+                proof_file = arg.substr(8);
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                threads = parse_int<uint32_t>(arg.substr(10));
+            } else if (arg == "-h" || arg == "--help") {
+                std::cout << "Usage: " << argv[0] << " [options]" << std::endl
+                          << "--proof=<path>            The proof file written by solve --proof" << std::endl
+                          << "--game={geodesic,custom}  The type of Y game the proof is for (default: geodesic)" << std::endl
+                          << "--base=N                  The size of the base of the board (geodesic Y only, default: 3)" << std::endl
+                          << "--board-file=<path>       Path to the board file (custom Y only, default: sample-board.txt)" << std::endl
+                          << "--no-renumber             The proof was written with --no-renumber (custom Y only)" << std::endl
+                          << "--threads=N               The number of threads to verify with (default: all cores)" << std::endl;
+                return EXIT_SUCCESS;
+            } else {
+                throw std::runtime_error("unknown argument: " + arg);
+            }
+        }
+
+        if (proof_file.empty()) {
+            throw std::runtime_error("error: no proof file given, use --proof=<path>");
+        }
+
+        if (game == Game::Geodesic) {
+            GeodesicY ygame{base};
+            verify_file(ygame, proof_file, threads);
+        } else if (game == Game::Custom) {
+            CustomY ygame{board_file, renumber};
+            verify_file(ygame, proof_file, threads);
+        }
+
+    } catch (const std::runtime_error& err) {
+        std::cout << err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -3,9 +3,32 @@
 #include <vector>
 
 #include "cell.hpp"
+#include "symmetry.hpp"
+#include "templates.hpp"
 
 struct YGame {
     virtual const std::vector<std::vector<Cell>>& graph() const = 0;
     virtual const std::vector<std::vector<Cell>>& perms() const = 0;
+    virtual const Symmetry& symmetry() const = 0;
     virtual Edge cell_edge(Cell cell) const = 0;
+
+    // The edge templates of the board, which may be none
+    virtual const EdgeTemplates& templates() const = 0;
+
+    // The number a cell goes by on the command line and in output, for boards
+    // that number their cells differently inside, and the cell a number names
+    virtual Cell cell_label(const Cell cell) const {
+        return cell;
+    }
+
+    virtual Cell label_cell(const Cell label) const {
+        return label;
+    }
+
+    // The order the search tries cells in, or none for the order of the cells
+    // themselves. Boards numbered differently inside keep the order of their labels.
+    virtual const std::vector<Cell>& move_order() const {
+        static const std::vector<Cell> none{};
+        return none;
+    }
 };